@@ -0,0 +1,175 @@
+/*
+  BOTLOOP
+  Copyright (C) 2020 Bernhard Schelling
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef _BOTLOOP_BOARDS_
+#define _BOTLOOP_BOARDS_
+
+#include "sim.h"
+
+static constexpr SBoard Boards[] =
+{
+SBoard("1" // Board 1
+"#######"
+"### ###"
+"##   ##"
+"#G   L#"
+"##   ##"
+"### ###"
+"#######"),
+
+SBoard("3" // Board 2
+"#####"
+"#G  #"
+"### #"
+"#R  #"
+"#####"),
+
+SBoard("2" // Board 3
+"#####"
+"## G#"
+"#R  #"
+"#  ##"
+"#####"),
+
+SBoard("3" // Board 4
+"######"
+"##G ##"
+"#    #"
+"#    #"
+"## D##"
+"######"),
+
+SBoard("4" // Board 5
+"#########"
+"#R ###  #"
+"##  #  ##"
+"###   ###"
+"###   ###"
+"##  #  ##"
+"#  ###  #"
+"# #####G#"
+"#########"),
+
+SBoard("5" // Board 6
+"#########"
+"#       #"
+"#G### ###"
+"#       #"
+"# # #####"
+"#   #R  #"
+"# ### ###"
+"#       #"
+"#########"),
+
+SBoard("5" // Board 7
+"##############"
+"## # # # # # #"
+"#      #     #"
+"###### ##### #"
+"#  #     #   #"
+"## #     ### #"
+"#D           #"
+"## #     # # #"
+"## #       # #"
+"## # ##### # #"
+"#            #"
+"## ##### ###G#"
+"#      #   # #"
+"##############"),
+
+SBoard("5" // Board 8
+"###########"
+"# #    G  #"
+"# # ### ###"
+"#   #     #"
+"# ###     #"
+"# #       #"
+"#####     #"
+"#   #     #"
+"# #L### ###"
+"# #       #"
+"###########"),
+	
+SBoard("6" // Board 9
+"##########"
+"#      # #"
+"#  #####G#"
+"#      # #"
+"##     # #"
+"##       #"
+"#R     ###"
+"##       #"
+"#### ### #"
+"##########"),
+
+SBoard("6" // Board 10
+"##############"
+"####D# # #####"
+"#            #"
+"#### ### #####"
+"#    ###     #"
+"#### ### #####"
+"#            #"
+"#### ### #####"
+"#            #"
+"#### # # #####"
+"#    # #     #"
+"#### # # #####"
+"#    # #    G#"
+"##############"),
+
+SBoard("7" // Bonus 1
+"#############"
+"#  G        #"
+"# # # ### ###"
+"#           #"
+"# ####### # #"
+"#   #       #"
+"# # #     # #"
+"# #       # #"
+"# # #  U  # #"
+"#         # #"
+"# # ### ### #"
+"# #         #"
+"#############"),
+
+SBoard("8" // Bonus 2
+"################"
+"#######G########"
+"##### # ########"
+"#####   ########"
+"##### # ########"
+"#         ######"
+"#   # # ########"
+"#           ####"
+"# # # #     ####"
+"#     #     ####"
+"# # ###     ####"
+"# # #       ####"
+"# # ### # ######"
+"#           ####"
+"# # # L## # ####"
+"################"),
+};
+
+enum EBoard { BOARD_LAST_NORMAL = 9, BOARD_LAST_BONUS = 11, BOARD_COUNT = sizeof(Boards)/sizeof(Boards[0]) };
+
+#endif //_BOTLOOP_BOARDS_
@@ -0,0 +1,297 @@
+/*
+  BOTLOOP
+  Copyright (C) 2020 Bernhard Schelling
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+//Headless benchmarks of the simulation, the solver, the maze generator and the program edit work of the game, builds
+//without ZillaLib (make botbench). All inputs come from fixed seeds so runs of different builds can be compared.
+
+#include "sim.h"
+#include "boards.h"
+#include <chrono>
+#include <algorithm>
+
+enum
+{
+	BENCH_STEPS = 1 << 22, BENCH_PROGRAMS = 64, BENCH_BATCH_PROGRAMS = 65536, //raw simulation
+	BENCH_SWARM_BOTS = 10000, BENCH_SWARM_FRAMES = 20, BENCH_SWARM_SIZE = 255, //like the swarm mode on a big maze
+	BENCH_GENERATE_CELLS = 20000,                                            //boards per run are this over the area
+	BENCH_EDITS = 1000, BENCH_CACHE_SIZE = 4096,                             //program edits while programming
+	BENCH_P99_REPS = 100,                                                    //fewer reps make the p99 the max
+};
+
+struct SBenchOptions
+{
+	int Reps, Warmup, Commands;
+	unsigned long long Seed;
+	const char* Filter;
+};
+static SBenchOptions Opt = { 10, 1, 5, 1, NULL };
+static volatile long long Sink; //results of the timed code go here so it can't be optimized away
+
+//Nearest rank percentile of sorted samples
+static double Percentile(const std::vector<double>& sorted, int pct)
+{
+	int rank = (int)((pct * sorted.size() + 99) / 100);
+	return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+//Times Warmup + Reps runs of fn and prints the percentiles of the repetitions as one JSON object, p99 only with enough
+//repetitions to differ from the max. fn returns how many items (steps, boards, edits) it processed which gives the
+//rate at the median time.
+template <typename F> static void Bench(const char* name, const char* unit, const F& fn)
+{
+	if (Opt.Filter && !strstr(name, Opt.Filter)) return;
+	for (int i = 0; i != Opt.Warmup; i++) fn();
+	std::vector<double> ms(Opt.Reps);
+	long long items = 0;
+	for (int i = 0; i != Opt.Reps; i++)
+	{
+		std::chrono::steady_clock::time_point t = std::chrono::steady_clock::now();
+		items = fn();
+		ms[i] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t).count();
+	}
+	std::sort(ms.begin(), ms.end());
+	double sum = 0;
+	for (double v : ms) sum += v;
+	printf("{\"name\":\"%s\",\"reps\":%d,\"%s\":%lld", name, Opt.Reps, unit, items);
+	printf(",\"min_ms\":%.4f,\"p50_ms\":%.4f,\"p90_ms\":%.4f", ms.front(), Percentile(ms, 50), Percentile(ms, 90));
+	if (Opt.Reps >= BENCH_P99_REPS) printf(",\"p99_ms\":%.4f", Percentile(ms, 99));
+	printf(",\"max_ms\":%.4f,\"mean_ms\":%.4f", ms.back(), sum / Opt.Reps);
+	printf(",\"%s_per_sec\":%.1f}\n", unit, (Percentile(ms, 50) > 0 ? items * 1000.0 / Percentile(ms, 50) : 0.0));
+	fflush(stdout);
+}
+
+static void RandomPrograms(std::vector<SProgram>& progs, int count, unsigned long long stream)
+{
+	SRandom rnd(Opt.Seed, stream);
+	for (SProgram& prog : progs)
+	{
+		prog.Bits = 0;
+		for (int i = 0; i != count; i++) prog.Set(i, (ECommand)rnd.Int(CMD_COUNT));
+	}
+}
+
+static const SBoard& LargestBoard()
+{
+	int best = 0;
+	for (int i = 1; i != BOARD_COUNT; i++) if (Boards[i].Width * Boards[i].Height > Boards[best].Width * Boards[best].Height) best = i;
+	return Boards[best];
+}
+
+//Bot steps of a single bot (RunProgram and the game), through the move table (SBoardMoves) and in lockstep batches
+//(Solve and the bruteforce), the bots ignore the goal in the first two so every run does the same number of steps
+static void BenchSimulation()
+{
+	const SBoard& board = LargestBoard();
+	int count = board.CommandCount;
+	std::vector<SProgram> progs(BENCH_PROGRAMS);
+	RandomPrograms(progs, count, 1);
+
+	Bench("step/bot", "steps", [&]()
+	{
+		long long sum = 0;
+		for (const SProgram& prog : progs)
+		{
+			SBotState bot = { board.Start, board.StartDir, 0 };
+			for (int i = 0; i != BENCH_STEPS / BENCH_PROGRAMS; i++) bot.Step(board, prog, count);
+			sum += bot.Cell;
+		}
+		Sink += sum;
+		return (long long)BENCH_STEPS;
+	});
+
+	static SBoardMoves moves;
+	moves.Build(board);
+	Bench("step/moves", "steps", [&]()
+	{
+		long long sum = 0;
+		for (const SProgram& prog : progs)
+		{
+			SBotState bot = { board.Start, board.StartDir, 0 };
+			for (int i = 0; i != BENCH_STEPS / BENCH_PROGRAMS; i++) moves.Step(bot, prog, count);
+			sum += bot.Cell;
+		}
+		Sink += sum;
+		return (long long)BENCH_STEPS;
+	});
+
+	std::vector<SProgram> batchProgs(BENCH_BATCH_PROGRAMS);
+	RandomPrograms(batchProgs, count, 2);
+	unsigned int targets[SBoard::PITCH] = { 0 };
+	targets[board.Goal / SBoard::PITCH] = (1u << (board.Goal % SBoard::PITCH));
+	Bench("step/batch", "steps", [&]()
+	{
+		SBotBatch batch(board.Walls, targets);
+		SBotState start = { board.Start, board.StartDir, 0 };
+		long long steps = 0;
+		for (int next = 0;;)
+		{
+			for (int lane; next != BENCH_BATCH_PROGRAMS && (lane = batch.FreeLane()) >= 0; next++)
+				batch.Add(lane, batchProgs[next], count, start, 0, next);
+			unsigned int finished = batch.Run();
+			if (!finished) return steps;
+			for (int lane = 0; lane != SBotBatch::LANES; lane++)
+				if (finished & (1u << lane)) steps += batch.Steps[lane];
+		}
+	});
+}
+
+//The swarm mode steps thousands of bots on an SMap every frame with SBotSwarm, the same as the game
+static void BenchSwarm()
+{
+	SMap map;
+	SProgram solution;
+	for (unsigned long long seed = Opt.Seed; !GenerateMaze(map, BENCH_SWARM_SIZE, BENCH_SWARM_SIZE, Opt.Commands, seed, solution); seed++) {}
+	SBotSwarm swarm;
+
+	Bench("step/swarm", "steps", [&]()
+	{
+		SRandom rnd(Opt.Seed, 3);
+		swarm.Start(map, BENCH_SWARM_BOTS, rnd);
+		for (int frame = 0; frame != BENCH_SWARM_FRAMES; frame++) swarm.Step(map);
+		Sink += swarm.Cleared;
+		return (long long)BENCH_SWARM_BOTS * BENCH_SWARM_FRAMES;
+	});
+}
+
+//Exhaustive solve of every built-in stage on all cores
+static void BenchSolve()
+{
+	for (int i = 0; i != BOARD_COUNT; i++)
+	{
+		char name[64];
+		snprintf(name, sizeof(name), "solve/builtin#%d", i + 1);
+		Bench(name, "boards", [&]()
+		{
+			SSolveResult res;
+			Solve(Boards[i], res);
+			Sink += res.Solutions;
+			return 1LL;
+		});
+	}
+}
+
+//Mazes as MakeBoard builds them, the normal sizes and two of the big marathon boards
+static void BenchGenerate()
+{
+	static const int sizes[] = { 7, 9, 11, 13, 15, 17, 19, 63, 255 };
+	for (int size : sizes)
+	{
+		char name[64];
+		snprintf(name, sizeof(name), "generate/%dx%d", size, size);
+		int boards = std::max(1, BENCH_GENERATE_CELLS / (size * size));
+		Bench(name, "boards", [&]()
+		{
+			SMap map;
+			SProgram prog;
+			SRandom rnd(Opt.Seed, (unsigned long long)size);
+			for (int i = 0; i != boards; i++)
+				while (!GenerateMaze(map, size, size, Opt.Commands, rnd.Next(), prog)) {}
+			Sink += map.Goal;
+			return (long long)boards;
+		});
+	}
+}
+
+//Work the game does on the CPU after the player edits the program: the path preview follows the edit and the instant
+//result looks up the outcome. Drawing needs ZillaLib and a display and is not part of it.
+static void BenchEdit()
+{
+	const SBoard& board = LargestBoard();
+	SMap map(board);
+	int count = board.CommandCount;
+	std::vector<SProgram> progs(BENCH_EDITS);
+	SRandom rnd(Opt.Seed, 4);
+	SProgram prog;
+	prog.Bits = 0;
+	for (SProgram& p : progs)
+	{
+		prog.Set(rnd.Int(count), (ECommand)rnd.Int(CMD_COUNT));
+		p = prog;
+	}
+	SBotState start = { map.Start, map.StartDir, 0 };
+
+	SPathTrace trace;
+	Bench("edit/preview", "edits", [&]()
+	{
+		long long steps = 0;
+		trace.Reset();
+		for (const SProgram& p : progs) { trace.Update(map, p, count); steps += trace.Steps(); }
+		Sink += steps;
+		return (long long)BENCH_EDITS;
+	});
+
+	SOutcomeCache cache(BENCH_CACHE_SIZE);
+	unsigned long long id = BoardHash(map);
+	Bench("edit/outcome", "edits", [&]()
+	{
+		long long cells = 0;
+		cache.Clear();
+		for (const SProgram& p : progs) cells += cache.Run(id, map, p, count, start).Cell;
+		Sink += cells;
+		return (long long)BENCH_EDITS;
+	});
+}
+
+static int Usage()
+{
+	fprintf(stderr, "Usage: botbench [--reps N] [--warmup N] [--seed N] [--commands N] [--filter TEXT]\n\n");
+	fprintf(stderr, "  --reps     Timed repetitions of every benchmark (default 10)\n");
+	fprintf(stderr, "  --warmup   Untimed runs before the repetitions (default 1)\n");
+	fprintf(stderr, "  --seed     Seed of all random programs and mazes (default 1)\n");
+	fprintf(stderr, "  --commands Command count of the generated mazes and the swarm (default 5)\n");
+	fprintf(stderr, "  --filter   Only run benchmarks with TEXT in their name (step, solve, generate, edit)\n\n");
+	fprintf(stderr, "Prints one JSON object per benchmark with the time percentiles of the repetitions in milliseconds,\n");
+	fprintf(stderr, "p99 only with at least %d repetitions.\n", BENCH_P99_REPS);
+	return 2;
+}
+
+int main(int argc, char *argv[])
+{
+	for (int i = 1; i < argc; i++)
+	{
+		const char* arg = argv[i], *val = (i + 1 < argc ? argv[i + 1] : "");
+		if      (!strcmp(arg, "--reps")     && sscanf(val, "%d", &Opt.Reps) == 1) i++;
+		else if (!strcmp(arg, "--warmup")   && sscanf(val, "%d", &Opt.Warmup) == 1) i++;
+		else if (!strcmp(arg, "--seed")     && sscanf(val, "%llu", &Opt.Seed) == 1) i++;
+		else if (!strcmp(arg, "--commands") && sscanf(val, "%d", &Opt.Commands) == 1) i++;
+		else if (!strcmp(arg, "--filter")   && *val) Opt.Filter = argv[++i];
+		else return Usage();
+	}
+	if (Opt.Reps < 1 || Opt.Warmup < 0 || Opt.Commands < 1 || Opt.Commands > SProgram::MAX_COMMANDS) return Usage();
+
+	#if defined(BOT_THREADS)
+	int threads = (int)std::thread::hardware_concurrency();
+	#else
+	int threads = 1;
+	#endif
+	#if defined(__AVX2__)
+	const char* simd = "avx2";
+	#else
+	const char* simd = "none";
+	#endif
+	printf("{\"bench\":\"botbench\",\"reps\":%d,\"warmup\":%d,\"seed\":%llu,\"commands\":%d,\"threads\":%d,\"simd\":\"%s\"}\n", Opt.Reps, Opt.Warmup, Opt.Seed, Opt.Commands, threads, simd);
+	BenchSimulation();
+	BenchSwarm();
+	BenchSolve();
+	BenchGenerate();
+	BenchEdit();
+	return 0;
+}
@@ -0,0 +1,605 @@
+/*
+  BOTLOOP
+  Copyright (C) 2020 Bernhard Schelling
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+//Headless batch tool to solve and validate boards, builds without ZillaLib (make botcli)
+
+#include "sim.h"
+#include "boards.h"
+#include "levelpack.h"
+#include "solutiondb.h"
+#include <string>
+#include <chrono>
+#include <memory>
+#include <unordered_set>
+
+//A board from a text file or a level in a pack
+struct SBoardDef { std::string Name, Def; const SLevelPack* Pack; int PackIdx; };
+
+static bool IsPackName(const char* name)
+{
+	size_t len = strlen(name);
+	return (len > 4 && !strcmp(name + len - 4, ".blp"));
+}
+
+//Reads boards in the same format as the Boards[] table or the MakeBoard output, either as C string literals with
+//boards separated by commas or as plain lines with boards separated by empty lines (which can be rectangular)
+static bool ReadBoardDefs(FILE* f, const char* name, std::vector<SBoardDef>& out)
+{
+	std::string text, cur;
+	char buf[4096];
+	for (size_t n; (n = fread(buf, 1, sizeof(buf), f)) > 0;) text.append(buf, n);
+	if (ferror(f)) return false;
+
+	int count = 0;
+	auto flush = [&]()
+	{
+		if (cur.empty()) return;
+		SBoardDef def = { std::string(name) + "#" + std::to_string(++count), cur, NULL, 0 };
+		out.push_back(def);
+		cur.clear();
+	};
+	for (size_t pos = 0; pos < text.size();)
+	{
+		size_t end = text.find('\n', pos);
+		if (end == std::string::npos) end = text.size();
+		std::string line = text.substr(pos, end - pos);
+		pos = end + 1;
+		if (!line.empty() && line.back() == '\r') line.pop_back();
+
+		bool inQuote = false, hasQuote = false, hasComma = false;
+		std::string quoted;
+		for (size_t i = 0; i != line.size(); i++)
+		{
+			char c = line[i];
+			if (c == '"') { inQuote ^= true; hasQuote = true; continue; }
+			if (inQuote) { quoted += c; continue; }
+			if (c == '/' && i + 1 < line.size() && line[i + 1] == '/') { line.resize(i); break; }
+			if (c == ',') hasComma = true;
+		}
+		if (hasQuote) { cur += quoted; if (hasComma) flush(); continue; }
+		if (line.find_first_not_of(" \t,") == std::string::npos) { flush(); continue; }
+		if (!cur.empty()) cur += '\n';
+		cur += line;
+	}
+	flush();
+	return true;
+}
+
+static void PrintJsonString(const char* key, const char* str)
+{
+	printf("\"%s\":\"", key);
+	for (const char* p = str; *p; p++)
+	{
+		if (*p == '"' || *p == '\\') putchar('\\');
+		if ((unsigned char)*p >= ' ') putchar(*p);
+	}
+	printf("\"");
+}
+
+enum EMode { MODE_SOLVE, MODE_VALIDATE, MODE_SEARCH, MODE_PACK, MODE_DB };
+
+//Boards found in here (--db) are not solved again
+static SSolutionDB SolutionDB;
+
+//Prints the first solution and the one with the fewest steps without counting all programs
+static bool SearchBoard(const char* name, const SBoard* board, const char* error)
+{
+	SSearchResult first, min;
+	double ms = 0;
+	if (board)
+	{
+		std::chrono::steady_clock::time_point t = std::chrono::steady_clock::now();
+		Search(*board, SEARCH_FIRST, first);
+		Search(*board, SEARCH_MIN_STEPS, min);
+		ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t).count();
+	}
+
+	printf("{");
+	PrintJsonString("name", name);
+	printf(",\"valid\":%s", (error ? "false" : "true"));
+	if (error) { printf(","); PrintJsonString("error", error); }
+	if (board)
+	{
+		printf(",\"width\":%d,\"height\":%d,\"commands\":%d,\"solved\":%s", board->Width, board->Height, board->CommandCount, (first.Solved ? "true" : "false"));
+		if (first.Solved)
+		{
+			printf(",\"first_steps\":%d,", first.Steps);
+			PrintJsonString("first_program", ProgramString(first.Program, board->CommandCount));
+			printf(",\"min_steps\":%d,", min.Steps);
+			PrintJsonString("min_steps_program", ProgramString(min.Program, board->CommandCount));
+		}
+		printf(",\"nodes\":%lld,\"ms\":%.3f", first.Nodes + min.Nodes, ms);
+	}
+	printf("}\n");
+	return !error;
+}
+
+//Prints one JSON object per line, returns false if the board is invalid or (when validating) unsolvable
+static bool ProcessBoard(const char* name, const SBoard* board, const char* error, EMode mode, SSolutionDBWriter* db)
+{
+	if (mode == MODE_SEARCH) return SearchBoard(name, board, error);
+	bool validate = (mode == MODE_VALIDATE), cached = false;
+	SSolveResult res;
+	int dead = -1; //open cells no program visits, only known from an exact reachability walk
+	double ms = 0;
+	if (board)
+	{
+		std::chrono::steady_clock::time_point t = std::chrono::steady_clock::now();
+		if (!(cached = SolutionDB.Lookup(*board, res))) Solve(*board, res, &dead);
+		ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t).count();
+		if (validate && !res.Solutions) error = (dead >= 0 ? "unsolvable, no program with this command count reaches the goal cell" : "unsolvable");
+		if (db) db->Add(*board, res);
+	}
+
+	printf("{");
+	PrintJsonString("name", name);
+	printf(",\"valid\":%s", (error ? "false" : "true"));
+	if (error) { printf(","); PrintJsonString("error", error); }
+	if (board)
+	{
+		printf(",\"width\":%d,\"height\":%d,\"commands\":%d,\"programs\":%lld,\"solutions\":%lld", board->Width, board->Height, board->CommandCount, res.Programs, res.Solutions);
+		if (res.Solutions)
+		{
+			printf(",\"min_steps\":%d,", res.MinSteps);
+			PrintJsonString("min_steps_program", ProgramString(res.MinStepsProgram, board->CommandCount));
+			printf(",\"min_commands\":%d,", res.MinCommands);
+			PrintJsonString("min_commands_program", ProgramString(res.MinCommandsProgram, board->CommandCount));
+		}
+		if (dead >= 0) printf(",\"dead_cells\":%d", dead);
+		if (cached) printf(",\"cached\":true");
+		printf(",\"ms\":%.3f", ms);
+	}
+	printf("}\n");
+	return !error;
+}
+
+struct SGenerateOptions
+{
+	int Count, MinSize, MaxSize, Commands, MinSteps, MaxSteps;
+	long long MaxSolutions;
+	unsigned long long Seed;
+};
+
+//Writes a board as plain lines with a comment line about its solution, the same format ReadBoardDefs reads
+static void WriteBoardDef(FILE* f, const SMap& map, const SSolveResult& res, unsigned long long seed, long long index)
+{
+	fprintf(f, "//seed %llu #%lld - %dx%d - %lld/%lld solutions - shortest %d steps [%s]\n", seed, index, map.Width, map.Height, res.Solutions, res.Programs, res.MinSteps, ProgramString(res.MinStepsProgram, map.CommandCount));
+	fprintf(f, "%d\n", map.CommandCount);
+	for (int y = map.Height - 1; y >= 0; y--)
+	{
+		for (int x = 0; x != map.Width; x++)
+		{
+			int cell = map.Cell(x, y);
+			fputc(cell == map.Start ? "RULD"[map.StartDir] : (cell == map.Goal ? 'G' : (map.IsWall(cell) ? '#' : ' ')), f);
+		}
+		fputc('\n', f);
+	}
+	fputc('\n', f);
+}
+
+//Generates graded boards in batches. Each batch is generated in parallel, then duplicates (also rotated or mirrored ones)
+//are dropped, the rest is solved in parallel and the boards in the wanted difficulty range are appended to the output
+//(as text or to a level pack if pack is set). The output only depends on the seed and not on the number of threads.
+enum { GENERATE_BATCH = 256, GENERATE_MAX_TRIES_PER_BOARD = 1000 };
+static int Generate(const SGenerateOptions& opt, FILE* out, SLevelPackWriter* pack, FILE* log)
+{
+	std::chrono::steady_clock::time_point t = std::chrono::steady_clock::now();
+	std::unordered_set<unsigned long long> seen;
+	std::vector<SMap> maps(GENERATE_BATCH);
+	std::vector<unsigned long long> hashes(GENERATE_BATCH);
+	std::vector<char> made(GENERATE_BATCH);
+	long long generated = 0, duplicates = 0, rejected = 0, accepted = 0, maxTries = (long long)opt.Count * GENERATE_MAX_TRIES_PER_BOARD;
+	for (long long first = 0; accepted < opt.Count && first < maxTries; first += GENERATE_BATCH)
+	{
+		ParallelFor(GENERATE_BATCH, [&](int i)
+		{
+			SRandom rnd(opt.Seed, (unsigned long long)(first + i));
+			int odds = (opt.MaxSize - opt.MinSize) / 2 + 1;
+			int w = opt.MinSize + rnd.Int(odds) * 2, h = opt.MinSize + rnd.Int(odds) * 2;
+			SProgram prog;
+			made[i] = GenerateMaze(maps[i], w, h, opt.Commands, ((unsigned long long)rnd.Next() << 32) | rnd.Next(), prog);
+			if (made[i]) hashes[i] = CanonicalBoardHash(maps[i]);
+		});
+
+		std::vector<SBoard> boards;
+		std::vector<int> index;
+		for (int i = 0; i != GENERATE_BATCH; i++)
+		{
+			if (!made[i]) continue;
+			generated++;
+			if (!seen.insert(hashes[i]).second) { duplicates++; continue; }
+			boards.push_back(SBoard());
+			maps[i].ToBoard(boards.back());
+			index.push_back(i);
+		}
+
+		std::vector<SSolveResult> res(boards.size());
+		Solve(boards.data(), (int)boards.size(), res.data());
+		for (size_t k = 0; k != boards.size() && accepted < opt.Count; k++)
+		{
+			const SSolveResult& r = res[k];
+			if (!r.Solutions || r.MinSteps < opt.MinSteps || r.MinSteps > opt.MaxSteps || r.Solutions > opt.MaxSolutions) { rejected++; continue; }
+			if (pack) pack->Add(maps[index[k]], &r);
+			else WriteBoardDef(out, maps[index[k]], r, opt.Seed, first + index[k]);
+			accepted++;
+		}
+		fflush(out);
+	}
+	double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t).count();
+	fprintf(log, "{\"summary\":true,\"generated\":%lld,\"duplicates\":%lld,\"rejected\":%lld,\"accepted\":%lld,\"ms\":%.3f}\n", generated, duplicates, rejected, accepted, ms);
+	return (accepted == opt.Count ? 0 : 1);
+}
+
+//Consistency checks of the solvers against plain simulation (botcli selftest), prints the failed checks and a summary
+//line and returns false if any failed
+enum { SELFTEST_BOARDS = 400, SELFTEST_MAX_COMMANDS = 5, SELFTEST_SEED = 9, SELFTEST_MAZES = 200, SELFTEST_REACH_COMMANDS = 7 };
+struct SSelfTest
+{
+	int Checks, Failed;
+
+	void Check(bool ok, const char* name, const char* what)
+	{
+		Checks++;
+		if (ok) return;
+		Failed++;
+		printf("{");
+		PrintJsonString("name", name);
+		printf(",");
+		PrintJsonString("failed", what);
+		printf("}\n");
+	}
+};
+
+//First program in program order that solves the board, by running all of them
+static bool FirstSolution(const SBoard& board, SProgram& first)
+{
+	int count = board.CommandCount, programs = 1;
+	for (int i = 0; i != count; i++) programs *= CMD_COUNT;
+	SBotState start = { board.Start, board.StartDir, 0 };
+	for (int p = 0; p != programs; p++)
+	{
+		first.Bits = 0;
+		for (int i = count - 1, digits = p; i >= 0; i--, digits /= CMD_COUNT) first.Set(i, (ECommand)(digits % CMD_COUNT));
+		if (RunProgram(board, first, count, start).Solved) return true;
+	}
+	return false;
+}
+
+//Search must find the same first solution and fewest steps as running every program
+static void SelfTestSearch(SSelfTest& t, const char* name, const SBoard& board)
+{
+	SProgram first;
+	SSearchResult res;
+	SSolveResult solve;
+	bool solvable = FirstSolution(board, first);
+	Search(board, SEARCH_FIRST, res);
+	t.Check(res.Solved == solvable && (!solvable || res.Program == first), name, "search first solution");
+	Solve(board, solve);
+	t.Check((solve.Solutions != 0) == solvable, name, "solve solvable");
+	Search(board, SEARCH_MIN_STEPS, res);
+	t.Check(res.Solved == solvable && (!solvable || (res.Steps == solve.MinSteps && res.Program == solve.MinStepsProgram)), name, "search fewest steps");
+}
+
+//States a program passes through until it reaches the goal or has gone around its loop once, a direction bit per cell
+static void MarkPath(const SBoard& board, const SProgram& prog, std::vector<unsigned char>& visited)
+{
+	int count = board.CommandCount;
+	SBotState bot = { board.Start, board.StartDir, 0 };
+	SRunResult run = RunProgram(board, prog, count, bot);
+	visited[bot.Cell] |= (unsigned char)(1 << bot.Dir);
+	for (int i = 0, n = run.Steps + run.CycleLength; i != n; i++) { bot.Step(board, prog, count); visited[bot.Cell] |= (unsigned char)(1 << bot.Dir); }
+}
+
+//The reachability analysis must find the same states as running every program, and the witness of a cell must get there
+static void SelfTestReachability(SSelfTest& t, const char* name, const SBoard& board)
+{
+	int count = board.CommandCount, programs = 1, wrong = 0;
+	for (int i = 0; i != count; i++) programs *= CMD_COUNT;
+	std::vector<unsigned char> visited(board.Cells());
+	for (int p = 0; p != programs; p++)
+	{
+		SProgram prog;
+		prog.Bits = 0;
+		for (int i = count - 1, digits = p; i >= 0; i--, digits /= CMD_COUNT) prog.Set(i, (ECommand)(digits % CMD_COUNT));
+		MarkPath(board, prog, visited);
+	}
+	SReachability reach(board);
+	for (int cell = 0; cell != board.Cells(); cell++)
+	{
+		if (board.IsWall(cell)) continue;
+		if (reach.Dirs[cell] != visited[cell]) { wrong++; continue; }
+		if (!reach.Visited(cell)) continue;
+		std::vector<unsigned char> path(board.Cells());
+		MarkPath(board, reach.Witness[cell], path);
+		if (!path[cell]) wrong++;
+	}
+	t.Check(reach.Exact && !wrong && reach.GoalReachable == (visited[board.Goal] != 0), name, "reachability");
+}
+
+//The swarm must end in the same states as single bots running the same programs, bots that reached the goal stay
+enum { SELFTEST_SWARM_BOTS = 1000, SELFTEST_SWARM_STEPS = 300 };
+static void SelfTestSwarm(SSelfTest& t, const char* name, const SMap& map)
+{
+	SBotSwarm swarm;
+	SRandom rnd(SELFTEST_SEED, 0);
+	swarm.Start(map, SELFTEST_SWARM_BOTS, rnd);
+	for (int i = 0; i != SELFTEST_SWARM_STEPS; i++) swarm.Step(map);
+	int cleared = 0, wrong = 0, count = map.CommandCount;
+	for (int i = 0; i != SELFTEST_SWARM_BOTS; i++)
+	{
+		SBotState bot = { map.Start, map.StartDir, 0 };
+		SRunResult run = RunProgram(map, swarm.Programs[i], count, bot);
+		bool solved = (run.Solved && run.Steps <= SELFTEST_SWARM_STEPS);
+		for (int step = 0; step != (solved ? run.Steps : SELFTEST_SWARM_STEPS); step++) bot.Step(map, swarm.Programs[i], count);
+		if (solved) cleared++;
+		if ((int)swarm.Pos[i] != ((bot.Cell << 2) | bot.Dir) || (!solved && swarm.Index[i] != bot.Index)) wrong++;
+	}
+	t.Check(!wrong && swarm.Cleared == cleared, name, "swarm states");
+}
+
+//A database entry only answers for the board it was written for, an entry with the same key but another check is unknown
+static void SelfTestSolutionDB(SSelfTest& t, const SBoard& board)
+{
+	SSolveResult res;
+	Solve(board, res);
+	for (int collide = 0; collide != 2; collide++)
+	{
+		SSolutionDBWriter writer;
+		writer.Add(board, res);
+		if (collide) writer.Entries[0].Check ^= 1;
+		FILE* f = tmpfile();
+		std::vector<unsigned char> data;
+		if (f && writer.Write(f))
+		{
+			rewind(f);
+			char buf[4096];
+			for (size_t n; (n = fread(buf, 1, sizeof(buf), f)) > 0;) data.insert(data.end(), buf, buf + n);
+		}
+		if (f) fclose(f);
+		SSolutionDB db;
+		SSolveResult found;
+		bool hit = (db.Load(data) && db.Lookup(board, found));
+		t.Check(collide ? !hit : (hit && found.Solutions == res.Solutions && found.MinStepsProgram == res.MinStepsProgram), "solution database", (collide ? "key collision" : "lookup"));
+	}
+}
+
+static int SelfTest()
+{
+	SSelfTest t = { 0, 0 };
+
+	//the goal is reached by programs of different lengths, the first in program order (__F) is not the shortest (F__)
+	SMap map("3\n#####\n#RG #\n#   #\n#####");
+	SBoard board;
+	map.ToBoard(board);
+	SelfTestSearch(t, "goal after different lengths", board);
+
+	for (int i = 0; i != SELFTEST_BOARDS; i++)
+	{
+		SRandom rnd(SELFTEST_SEED, (unsigned long long)i);
+		int size = 5 + rnd.Int(3) * 2;
+		map.Reset(size, size);
+		for (int y = 0; y != size; y++)
+			for (int x = 0; x != size; x++)
+				if (rnd.Int(100) < 30) map.SetWall(x, y, true);
+		int sx = rnd.Int(size), sy = rnd.Int(size), gx, gy;
+		do { gx = rnd.Int(size); gy = rnd.Int(size); } while (gx == sx && gy == sy);
+		map.SetWall(sx, sy, false);
+		map.SetWall(gx, gy, false);
+		map.Start = map.Cell(sx, sy);
+		map.StartDir = rnd.Int(4);
+		map.Goal = map.Cell(gx, gy);
+		map.CommandCount = 1 + rnd.Int(SELFTEST_MAX_COMMANDS);
+		map.ToBoard(board);
+		std::string name = "random#" + std::to_string(i + 1);
+		SelfTestSearch(t, name.c_str(), board);
+		SelfTestReachability(t, name.c_str(), board);
+	}
+
+	for (int i = 0; i != BOARD_COUNT; i++)
+	{
+		std::string name = "builtin#" + std::to_string(i + 1);
+		SelfTestSwarm(t, name.c_str(), SMap(Boards[i]));
+		if (Boards[i].CommandCount <= SELFTEST_REACH_COMMANDS) SelfTestReachability(t, name.c_str(), Boards[i]);
+	}
+	SelfTestSolutionDB(t, Boards[BOARD_COUNT - 1]);
+
+	SProgram prog;
+	for (unsigned long long seed = SELFTEST_SEED; !GenerateMaze(map, 63, 41, 5, seed, prog); seed++) {}
+	SelfTestSwarm(t, "maze 63x41", map);
+
+	//the program returned with a generated maze must solve it
+	for (int i = 0; i != SELFTEST_MAZES; i++)
+	{
+		SRandom rnd(SELFTEST_SEED, (unsigned long long)i);
+		int size = 7 + rnd.Int(10) * 2, count = 1 + rnd.Int(8);
+		if (!GenerateMaze(map, size, size, count, rnd.Next(), prog)) continue;
+		SBotState start = { map.Start, map.StartDir, 0 };
+		std::string name = "maze#" + std::to_string(i + 1);
+		t.Check(map.Goal != map.Start && RunProgram(map, prog, count, start).Solved, name.c_str(), "maze program");
+	}
+
+	printf("{\"selftest\":true,\"checks\":%d,\"failed\":%d}\n", t.Checks, t.Failed);
+	return (t.Failed ? 1 : 0);
+}
+
+static int Usage()
+{
+	fprintf(stderr, "Usage: botcli <solve|validate|search> [--db <file.bsdb>] [--builtin] [file...]\n");
+	fprintf(stderr, "       botcli generate [--count N] [--size MIN-MAX] [--commands N] [--steps MIN-MAX] [--max-solutions N] [--seed N] <file>\n");
+	fprintf(stderr, "       botcli pack --out <file.blp> [--solve] [--normal N] [--db <file.bsdb>] [--builtin] [file...]\n");
+	fprintf(stderr, "       botcli db --out <file.bsdb> [--db <file.bsdb>] [--builtin] [file...]\n");
+	fprintf(stderr, "       botcli selftest\n\n");
+	fprintf(stderr, "  solve     Solve every board exhaustively and print one JSON object per board\n");
+	fprintf(stderr, "  validate  Like solve but unsolvable boards count as invalid, exits with 1 if any board is invalid\n");
+	fprintf(stderr, "  search    Only find the first solution and the one with the fewest steps\n");
+	fprintf(stderr, "  --builtin Process the boards built into the game\n");
+	fprintf(stderr, "  --db      Take the solve results of boards found in a solution database instead of solving them again\n");
+	fprintf(stderr, "  generate  Generate, deduplicate, solve and filter random mazes and write the accepted boards to file (- for stdout)\n");
+	fprintf(stderr, "            Defaults: --count 100 --size 7-19 --commands 5 --steps 0-1000000 --seed 1, sizes must be odd from 5 to 29\n");
+	fprintf(stderr, "  pack      Write the boards into a binary level pack, --solve adds the solution metadata, --normal sets how many\n");
+	fprintf(stderr, "            of them are normal stages (the rest are bonus stages)\n");
+	fprintf(stderr, "  db        Solve the boards and write their results into a solution database (looked up by board in constant time)\n");
+	fprintf(stderr, "  selftest  Check the solvers and the swarm against running every program on random boards, exits with 1 if a\n");
+	fprintf(stderr, "            check fails\n\n");
+	fprintf(stderr, "Boards are read from the given files (- for stdin) or from stdin if there are none.\n");
+	fprintf(stderr, "Files ending with .blp are binary level packs, generate writes one if the output file name ends with .blp.\n");
+	return 2;
+}
+
+static int GenerateMain(int argc, char *argv[])
+{
+	SGenerateOptions opt = { 100, 7, 19, 5, 0, 1000000, 0x7FFFFFFFFFFFFFFFll, 1 };
+	const char* file = NULL;
+	for (int i = 2; i < argc; i++)
+	{
+		const char* arg = argv[i], *val = (i + 1 < argc ? argv[i + 1] : "");
+		if      (!strcmp(arg, "--count")         && sscanf(val, "%d", &opt.Count) == 1) i++;
+		else if (!strcmp(arg, "--size")          && sscanf(val, "%d-%d", &opt.MinSize, &opt.MaxSize) >= 1) { if (!strchr(val, '-')) opt.MaxSize = opt.MinSize; i++; }
+		else if (!strcmp(arg, "--commands")      && sscanf(val, "%d", &opt.Commands) == 1) i++;
+		else if (!strcmp(arg, "--steps")         && sscanf(val, "%d-%d", &opt.MinSteps, &opt.MaxSteps) == 2) i++;
+		else if (!strcmp(arg, "--max-solutions") && sscanf(val, "%lld", &opt.MaxSolutions) == 1) i++;
+		else if (!strcmp(arg, "--seed")          && sscanf(val, "%llu", &opt.Seed) == 1) i++;
+		else if (!file && (arg[0] != '-' || !arg[1])) file = arg;
+		else return Usage();
+	}
+	if (!file || opt.Count < 1 || opt.Commands < 1 || opt.Commands > SProgram::MAX_COMMANDS) return Usage();
+	if (!(opt.MinSize & 1) || !(opt.MaxSize & 1) || opt.MinSize < 5 || opt.MaxSize > SBoard::MAX_SIZE || opt.MinSize > opt.MaxSize) return Usage();
+
+	bool isPack = IsPackName(file);
+	FILE* out = (strcmp(file, "-") ? fopen(file, "wb") : stdout);
+	SLevelPackWriter pack;
+	if (!out || (isPack && (out == stdout || !pack.Begin(out)))) { fprintf(stderr, "Could not write %s\n", file); return 1; }
+	int result = Generate(opt, out, (isPack ? &pack : NULL), (out == stdout ? stderr : stdout));
+	if (isPack && !pack.End(-1)) { fprintf(stderr, "Could not write %s\n", file); result = 1; }
+	if (out != stdout) fclose(out);
+	return result;
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc < 2) return Usage();
+	if (!strcmp(argv[1], "generate")) return GenerateMain(argc, argv);
+	if (!strcmp(argv[1], "selftest")) return (argc == 2 ? SelfTest() : Usage());
+	EMode mode = (!strcmp(argv[1], "solve") ? MODE_SOLVE : (!strcmp(argv[1], "validate") ? MODE_VALIDATE : (!strcmp(argv[1], "pack") ? MODE_PACK : (!strcmp(argv[1], "db") ? MODE_DB : MODE_SEARCH))));
+	bool validate = (mode == MODE_VALIDATE), builtin = false, solve = false;
+	if (mode == MODE_SEARCH && strcmp(argv[1], "search")) return Usage();
+
+	std::vector<SBoardDef> defs;
+	std::vector<std::unique_ptr<SLevelPack> > packs;
+	const char* out = NULL;
+	int files = 0, invalid = 0, result = 0, normal = -1;
+	for (int i = 2; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "--builtin")) { builtin = true; continue; }
+		if (mode == MODE_PACK && !strcmp(argv[i], "--solve")) { solve = true; continue; }
+		if ((mode == MODE_PACK || mode == MODE_DB) && !strcmp(argv[i], "--out") && i + 1 < argc) { out = argv[++i]; continue; }
+		if (mode != MODE_SEARCH && !strcmp(argv[i], "--db") && i + 1 < argc)
+		{
+			if (!SolutionDB.Load(argv[++i])) { fprintf(stderr, "Could not read %s\n", argv[i]); return 1; }
+			continue;
+		}
+		if (mode == MODE_PACK && !strcmp(argv[i], "--normal") && i + 1 < argc && sscanf(argv[i + 1], "%d", &normal) == 1) { i++; continue; }
+		if (argv[i][0] == '-' && argv[i][1]) return Usage();
+		files++;
+		if (IsPackName(argv[i]))
+		{
+			packs.emplace_back(new SLevelPack());
+			if (!packs.back()->Load(argv[i])) { fprintf(stderr, "Could not read %s\n", argv[i]); result = 1; continue; }
+			for (int j = 0; j != packs.back()->Count(); j++)
+			{
+				SBoardDef def = { std::string(argv[i]) + "#" + std::to_string(j + 1), std::string(), packs.back().get(), j };
+				defs.push_back(def);
+			}
+			continue;
+		}
+		FILE* f = (strcmp(argv[i], "-") ? fopen(argv[i], "rb") : stdin);
+		if (!f || !ReadBoardDefs(f, (f == stdin ? "stdin" : argv[i]), defs)) { fprintf(stderr, "Could not read %s\n", argv[i]); result = 1; }
+		if (f && f != stdin) fclose(f);
+	}
+	if (!files && !builtin) ReadBoardDefs(stdin, "stdin", defs);
+
+	SLevelPackWriter pack;
+	FILE* packFile = NULL;
+	if (mode == MODE_PACK)
+	{
+		if (!out) return Usage();
+		if (!(packFile = fopen(out, "wb")) || !pack.Begin(packFile)) { fprintf(stderr, "Could not write %s\n", out); return 1; }
+		if (normal < 0 && builtin && !files) normal = BOARD_LAST_NORMAL + 1;
+	}
+	SSolutionDBWriter db, *dbOut = (mode == MODE_DB ? &db : NULL);
+	if (mode == MODE_DB && !out) return Usage();
+
+	//boards are added to the pack as they are, with the solution metadata if requested and the board fits the solver
+	auto addToPack = [&](const SMap& map)
+	{
+		SBoard board;
+		SSolveResult res;
+		bool solved = (solve && map.ToBoard(board));
+		if (solved && !SolutionDB.Lookup(board, res)) Solve(board, res);
+		pack.Add(map, (solved ? &res : NULL));
+	};
+
+	std::chrono::steady_clock::time_point t = std::chrono::steady_clock::now();
+	if (builtin)
+	{
+		for (int i = 0; i != BOARD_COUNT; i++)
+		{
+			std::string name = "builtin#" + std::to_string(i + 1);
+			if (mode == MODE_PACK) addToPack(SMap(Boards[i]));
+			else if (!ProcessBoard(name.c_str(), &Boards[i], NULL, mode, dbOut)) invalid++;
+		}
+	}
+	for (const SBoardDef& def : defs)
+	{
+		SMap map;
+		const char* error = NULL;
+		if (def.Pack) { if (!def.Pack->GetMap(def.PackIdx, map)) error = "invalid level in pack"; }
+		else if (!(error = CheckBoardDef(def.Def.c_str()))) map = SMap(def.Def.c_str());
+		if (mode == MODE_PACK)
+		{
+			if (!error) { addToPack(map); continue; }
+			printf("{");
+			PrintJsonString("name", def.Name.c_str());
+			printf(",\"valid\":false,");
+			PrintJsonString("error", error);
+			printf("}\n");
+			invalid++;
+			continue;
+		}
+		SBoard board;
+		if (!error && !map.ToBoard(board)) error = "board too large for the solver";
+		if (!ProcessBoard(def.Name.c_str(), (error ? NULL : &board), error, mode, dbOut)) invalid++;
+	}
+	if (packFile)
+	{
+		if (!pack.End(normal)) { fprintf(stderr, "Could not write %s\n", out); result = 1; }
+		fclose(packFile);
+	}
+	if (mode == MODE_DB)
+	{
+		FILE* f = fopen(out, "wb");
+		if (!f || !db.Write(f)) { fprintf(stderr, "Could not write %s\n", out); result = 1; }
+		if (f) fclose(f);
+	}
+	double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t).count();
+	printf("{\"summary\":true,\"boards\":%d,\"invalid\":%d,\"ms\":%.3f}\n", (int)(defs.size() + (builtin ? BOARD_COUNT : 0)), invalid, ms);
+	return (result || (validate && invalid) ? 1 : 0);
+}
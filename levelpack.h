@@ -0,0 +1,238 @@
+/*
+  BOTLOOP
+  Copyright (C) 2020 Bernhard Schelling
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#ifndef _BOTLOOP_LEVELPACK_
+#define _BOTLOOP_LEVELPACK_
+
+//Binary level pack: a header, the level records and an index with the file offset of every level. The records can be
+//used right where they are in memory, so opening a pack only checks the header and the index, and any level is found
+//in constant time. All values are little endian.
+//
+//  SLevelPackHeader
+//  SLevelPackLevel, Height rows (bottom row first) of WordsPerRow() wall words, padded to 8 bytes   (for every level)
+//  unsigned long long Offsets[LevelCount]                                                           (at IndexOffset)
+
+#include "sim.h"
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define BOT_MMAP
+#endif
+
+enum { LEVELPACK_VERSION = 2, LEVELPACK_SOLVED = 1 };
+
+struct SLevelPackHeader
+{
+	char Magic[4]; //BLPK
+	unsigned int Version, LevelCount, NormalCount; //levels after the normal ones are bonus stages
+	unsigned long long IndexOffset;
+};
+
+struct SLevelPackLevel
+{
+	long long Solutions, Programs; //solution metadata, only set with LEVELPACK_SOLVED
+	unsigned short Width, Height, StartX, StartY, GoalX, GoalY;
+	unsigned char CommandCount, StartDir, Flags, Reserved;
+	int MinSteps, Reserved2;
+	unsigned long long MinStepsProgram; //SProgram bits
+
+	int WordsPerRow() const { return (Width + 31) / 32; }
+	size_t Size() const { return (sizeof(SLevelPackLevel) + (size_t)Height * WordsPerRow() * 4 + 7) & ~(size_t)7; }
+	const unsigned int* Walls() const { return (const unsigned int*)(this + 1); }
+	bool IsWall(int x, int y) const { return (Walls()[y * WordsPerRow() + (x >> 5)] >> (x & 31)) & 1; }
+};
+
+//File contents used in place, memory mapped where possible, otherwise read into a buffer
+struct SMappedFile
+{
+	const unsigned char* Data;
+	size_t Size;
+	std::vector<unsigned char> Buffer; //file contents when it can't be mapped
+	void* Mapping;
+	size_t MappingSize;
+
+	SMappedFile() : Data(NULL), Size(0), Mapping(NULL), MappingSize(0) { }
+	~SMappedFile() { Close(); }
+
+	void Close()
+	{
+		#if defined(BOT_MMAP)
+		if (Mapping) munmap(Mapping, MappingSize);
+		#endif
+		Data = NULL;
+		Size = 0;
+		Mapping = NULL;
+		MappingSize = 0;
+		Buffer.clear();
+	}
+
+	//Takes over data already loaded into memory (like from a ZL_File)
+	bool Load(std::vector<unsigned char>& data)
+	{
+		Close();
+		Buffer.swap(data);
+		Data = Buffer.data();
+		Size = Buffer.size();
+		return true;
+	}
+
+	bool Load(const char* path)
+	{
+		Close();
+		#if defined(BOT_MMAP)
+		int fd = open(path, O_RDONLY);
+		if (fd < 0) return false;
+		struct stat st;
+		void* p = (fstat(fd, &st) == 0 && st.st_size > 0 ? mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED);
+		close(fd);
+		if (p != MAP_FAILED)
+		{
+			Data = (const unsigned char*)(Mapping = p);
+			Size = MappingSize = (size_t)st.st_size;
+			return true;
+		}
+		#endif
+		FILE* f = fopen(path, "rb");
+		if (!f) return false;
+		char buf[4096];
+		for (size_t n; (n = fread(buf, 1, sizeof(buf), f)) > 0;) Buffer.insert(Buffer.end(), buf, buf + n);
+		fclose(f);
+		Data = Buffer.data();
+		Size = Buffer.size();
+		return true;
+	}
+
+private:
+	SMappedFile(const SMappedFile&);
+	SMappedFile& operator=(const SMappedFile&);
+};
+
+struct SLevelPack : SMappedFile
+{
+	//Returns false if the file is missing or not a valid pack
+	bool Load(std::vector<unsigned char>& data) { return SMappedFile::Load(data) && Open(); }
+	bool Load(const char* path) { return SMappedFile::Load(path) && Open(); }
+
+	int Count() const { return (Data ? (int)Header().LevelCount : 0); }
+	int NormalCount() const { return (Data ? (int)Header().NormalCount : 0); }
+	const SLevelPackHeader& Header() const { return *(const SLevelPackHeader*)Data; }
+
+	//Returns NULL if the record doesn't fit into the file
+	const SLevelPackLevel* Level(int idx) const
+	{
+		if (idx < 0 || idx >= Count()) return NULL;
+		unsigned long long offset = ((const unsigned long long*)(Data + Header().IndexOffset))[idx];
+		if ((offset & 7) || offset < sizeof(SLevelPackHeader) || offset + sizeof(SLevelPackLevel) > Size) return NULL;
+		const SLevelPackLevel* lvl = (const SLevelPackLevel*)(Data + offset);
+		if (offset + lvl->Size() > Size) return NULL;
+		return lvl;
+	}
+
+	bool GetMap(int idx, SMap& map) const
+	{
+		const SLevelPackLevel* lvl = Level(idx);
+		if (!lvl || lvl->Width < 3 || lvl->Height < 3 || lvl->Width > SMap::MAX_SIZE || lvl->Height > SMap::MAX_SIZE) return false;
+		map.Reset(lvl->Width, lvl->Height);
+		for (int y = 0; y != lvl->Height; y++)
+			for (int x = 0; x != lvl->Width; x++)
+				if (lvl->IsWall(x, y)) map.SetWall(x, y, true);
+		map.CommandCount = lvl->CommandCount;
+		map.StartDir = lvl->StartDir & 3;
+		map.Start = map.Cell(lvl->StartX % lvl->Width, lvl->StartY % lvl->Height);
+		map.Goal = map.Cell(lvl->GoalX % lvl->Width, lvl->GoalY % lvl->Height);
+		return true;
+	}
+
+private:
+	bool Open()
+	{
+		const SLevelPackHeader* h = (const SLevelPackHeader*)Data;
+		if (Size < sizeof(SLevelPackHeader) || memcmp(h->Magic, "BLPK", 4) || h->Version != LEVELPACK_VERSION ||
+			(h->IndexOffset & 7) || h->IndexOffset > Size || (Size - h->IndexOffset) / 8 < h->LevelCount || h->NormalCount > h->LevelCount) { Close(); return false; }
+		return true;
+	}
+};
+
+//Writes a pack level by level, the index and the header are written by End so the file needs to be seekable
+struct SLevelPackWriter
+{
+	FILE* File;
+	unsigned long long Pos;
+	std::vector<unsigned long long> Offsets;
+
+	bool Begin(FILE* f)
+	{
+		SLevelPackHeader h;
+		memset(&h, 0, sizeof(h));
+		File = f;
+		Pos = sizeof(h);
+		Offsets.clear();
+		return fwrite(&h, sizeof(h), 1, f) == 1;
+	}
+
+	void Add(const SMap& map, const SSolveResult* res = NULL)
+	{
+		SLevelPackLevel lvl;
+		memset(&lvl, 0, sizeof(lvl));
+		lvl.Width = (unsigned short)map.Width;
+		lvl.Height = (unsigned short)map.Height;
+		lvl.StartX = (unsigned short)map.CellX(map.Start);
+		lvl.StartY = (unsigned short)map.CellY(map.Start);
+		lvl.GoalX = (unsigned short)map.CellX(map.Goal);
+		lvl.GoalY = (unsigned short)map.CellY(map.Goal);
+		lvl.CommandCount = (unsigned char)map.CommandCount;
+		lvl.StartDir = (unsigned char)map.StartDir;
+		if (res && res->Solutions)
+		{
+			lvl.Flags = LEVELPACK_SOLVED;
+			lvl.Solutions = res->Solutions;
+			lvl.Programs = res->Programs;
+			lvl.MinSteps = res->MinSteps;
+			lvl.MinStepsProgram = res->MinStepsProgram.Bits;
+		}
+
+		std::vector<unsigned int> walls((lvl.Size() - sizeof(lvl)) / 4);
+		for (int y = 0; y != map.Height; y++)
+			for (int x = 0; x != map.Width; x++)
+				if (map.IsWall(map.Cell(x, y))) walls[y * lvl.WordsPerRow() + (x >> 5)] |= (1u << (x & 31));
+		fwrite(&lvl, sizeof(lvl), 1, File);
+		fwrite(walls.data(), 4, walls.size(), File);
+		Offsets.push_back(Pos);
+		Pos += lvl.Size();
+	}
+
+	bool End(int normalCount)
+	{
+		SLevelPackHeader h;
+		memcpy(h.Magic, "BLPK", 4);
+		h.Version = LEVELPACK_VERSION;
+		h.LevelCount = (unsigned int)Offsets.size();
+		h.NormalCount = (unsigned int)(normalCount < 0 ? Offsets.size() : normalCount);
+		h.IndexOffset = Pos;
+		if (!Offsets.empty()) fwrite(Offsets.data(), 8, Offsets.size(), File);
+		return (!fseek(File, 0, SEEK_SET) && fwrite(&h, sizeof(h), 1, File) == 1 && !fseek(File, 0, SEEK_END) && !ferror(File));
+	}
+};
+
+#endif //_BOTLOOP_LEVELPACK_
@@ -25,17 +25,21 @@
 #include <ZL_Audio.h>
 #include <ZL_Font.h>
 #include <ZL_Input.h>
+#include <ZL_File.h>
 #include <ZL_SynthImc.h>
 #include <vector>
+#include "sim.h"
+#include "boards.h"
+#include "levelpack.h"
+#include "solutiondb.h"
 using namespace std;
 
 static ZL_Font fntMain, fntBig;
-static ZL_Surface srfBot, srfTiles;
+static ZL_Surface srfBot, srfTiles, srfTitle;
 static ZL_Sound sndSelect, sndRun, sndReturn, sndClear, sndStage, sndMove, sndBump;
 static ZL_SynthImcTrack imcMusic;
 
-enum ECommand { CMD_NONE, CMD_FORWARD, CMD_REVERSE, CMD_TURNLEFT, CMD_TURNRIGHT, CMD_COUNT };
-enum EBotState { BOT_PROGRAMMING, BOT_RUNNING, BOT_CLEARED };
+enum EBotState { BOT_PROGRAMMING, BOT_RUNNING, BOT_SOLVED, BOT_CLEARED }; //solved waits on the goal after an instant result
 enum ETiles
 {
 	TILE_FLAG = 8,
@@ -67,161 +71,163 @@ static int tileCommands[CMD_COUNT] = { (int)TILE_CMD_NONE, (int)TILE_CMD_FORWARD
 
 static ZL_Color BackGradient[4], GradientColors[] = { ZLRGBX(0x051e3e), ZLRGBX(0x251e3e), ZLRGBX(0x451e3e), ZLRGBX(0x651e3e), ZLRGBX(0x851e3e) };
 
-static const char* Boards[] =
+//The level being played can be rectangular and much bigger than an SBoard, Board is only valid for the solvers (in the
+//debug build) if it fits
+static SMap Level;
+static SBoard Board;
+static bool BoardFits;
+static int BoardIdx;
+
+//Outcomes of programs run on the current and earlier boards, so toggling commands back and forth doesn't simulate again
+enum { OUTCOME_CACHE_SIZE = 4096 };
+static SOutcomeCache Outcomes(OUTCOME_CACHE_SIZE);
+static unsigned long long LevelId; //BoardHash of Level
+
+//Stages come from Data/levels.blp if it exists, otherwise from the built-in table
+static SLevelPack LevelPack;
+static int BoardCount = BOARD_COUNT, LastNormalBoard = BOARD_LAST_NORMAL;
+static bool IsLastNormalBoard() { return BoardIdx == LastNormalBoard && BoardIdx != BoardCount - 1; }
+
+//Solve results of known boards from Data/solutions.bsdb (built with botcli db)
+static SSolutionDB SolutionDB;
+
+//The data files are mapped from disk where levelpack.h can map (BOT_MMAP) and the game reads loose files. On Android
+//and the web the data lives in the package or a preloaded archive only ZL_File can open, there (or when the file isn't
+//on disk) it is read into a buffer which the pack then owns, one copy of the file in memory.
+template <typename TFile> static bool LoadDataFile(TFile& file, const char* path)
 {
-"1" // Board 1
-"#######"
-"### ###"
-"##   ##"
-"#G   L#"
-"##   ##"
-"### ###"
-"#######",
-
-"3" // Board 2
-"#####"
-"#G  #"
-"### #"
-"#R  #"
-"#####",
-
-"2" // Board 3
-"#####"
-"## G#"
-"#R  #"
-"#  ##"
-"#####",
-
-"3" // Board 4
-"######"
-"##G ##"
-"#    #"
-"#    #"
-"## D##"
-"######",
-
-"4" // Board 5
-"#########"
-"#R ###  #"
-"##  #  ##"
-"###   ###"
-"###   ###"
-"##  #  ##"
-"#  ###  #"
-"# #####G#"
-"#########",
-
-"5" // Board 6
-"#########"
-"#       #"
-"#G### ###"
-"#       #"
-"# # #####"
-"#   #R  #"
-"# ### ###"
-"#       #"
-"#########",
-
-"5" // Board 7
-"##############"
-"## # # # # # #"
-"#      #     #"
-"###### ##### #"
-"#  #     #   #"
-"## #     ### #"
-"#D           #"
-"## #     # # #"
-"## #       # #"
-"## # ##### # #"
-"#            #"
-"## ##### ###G#"
-"#      #   # #"
-"##############",
-
-"5" // Board 8
-"###########"
-"# #    G  #"
-"# # ### ###"
-"#   #     #"
-"# ###     #"
-"# #       #"
-"#####     #"
-"#   #     #"
-"# #L### ###"
-"# #       #"
-"###########",
-	
-"6" // Board 9
-"##########"
-"#      # #"
-"#  #####G#"
-"#      # #"
-"##     # #"
-"##       #"
-"#R     ###"
-"##       #"
-"#### ### #"
-"##########",
-
-"6" // Board 10
-"##############"
-"####D# # #####"
-"#            #"
-"#### ### #####"
-"#    ###     #"
-"#### ### #####"
-"#            #"
-"#### ### #####"
-"#            #"
-"#### # # #####"
-"#    # #     #"
-"#### # # #####"
-"#    # #    G#"
-"##############",
-
-"7" // Bonus 1
-"#############"
-"#  G        #"
-"# # # ### ###"
-"#           #"
-"# ####### # #"
-"#   #       #"
-"# # #     # #"
-"# #       # #"
-"# # #  U  # #"
-"#         # #"
-"# # ### ### #"
-"# #         #"
-"#############",
-
-"8" // Bonus 2
-"################"
-"#######G########"
-"##### # ########"
-"#####   ########"
-"##### # ########"
-"#         ######"
-"#   # # ########"
-"#           ####"
-"# # # #     ####"
-"#     #     ####"
-"# # ###     ####"
-"# # #       ####"
-"# # ### # ######"
-"#           ####"
-"# # # L## # ####"
-"################",
-};
+	#if defined(BOT_MMAP) && !defined(__ANDROID__) && !defined(__EMSCRIPTEN__)
+	if (file.Load(path)) return true;
+	#endif
+	std::vector<unsigned char> data;
+	return (ZL_File::Exists(path) && ZL_File(path).GetContents(data) && file.Load(data));
+}
 
-static const char* Board;
-static int BoardIdx, BoardSize;
-enum EBoard { BOARD_LAST_NORMAL = 9, BOARD_LAST_BONUS = 11 };
-#define TILE(X,Y) Board[(BoardSize - 1 - Y) * BoardSize + X]
+//Bordered text is rendered once with its eight border passes into a surface which is then drawn as a single quad
+struct SBorderedText
+{
+	ZL_String Text;
+	float Scale;
+	ZL_Color Fill, Border;
+	int BorderSize;
+	ZL_Vector Dimensions;
+	ZL_Surface Surface;
+};
 
 static void DrawTextBordered(const ZL_Vector& p, const char* txt, float scale = 1, const ZL_Color& colfill = ZLWHITE, const ZL_Color& colborder = ZLBLACK, int border = 2, ZL_Origin::Type origin = ZL_Origin::Center)
 {
-	for (int i = 0; i < 9; i++) if (i != 4) fntMain.Draw(p.x+(border*((i%3)-1)), p.y+8+(border*((i/3)-1)), txt, scale, scale, colborder, origin);
-	fntMain.Draw(p.x  , p.y+8  , txt, scale, scale, colfill, origin);
+	static std::vector<SBorderedText> cache;
+	SBorderedText* t = NULL;
+	for (SBorderedText& it : cache)
+		if (it.Scale == scale && it.BorderSize == border && it.Fill == colfill && it.Border == colborder && it.Text == txt) { t = &it; break; }
+	if (!t)
+	{
+		if (cache.size() == 64) cache.clear();
+		SBorderedText n;
+		n.Text = txt;
+		n.Scale = scale;
+		n.Fill = colfill;
+		n.Border = colborder;
+		n.BorderSize = border;
+		n.Dimensions = fntMain.GetDimensions(txt, scale, scale);
+		n.Surface = ZL_Surface((int)n.Dimensions.x + border * 2 + 2, (int)n.Dimensions.y + border * 2 + 2, true);
+		n.Surface.RenderToBegin(true);
+		for (int i = 0; i < 9; i++) if (i != 4) fntMain.Draw(s(border+1+(border*((i%3)-1))), s(border+1+(border*((i/3)-1))), txt, scale, scale, colborder, ZL_Origin::BottomLeft);
+		fntMain.Draw(s(border+1), s(border+1), txt, scale, scale, colfill, ZL_Origin::BottomLeft);
+		n.Surface.RenderToEnd();
+		cache.push_back(n);
+		t = &cache.back();
+	}
+
+	//place the text box (without the border margin) like fntMain.Draw would with the given origin
+	float ax = .5f, ay = .5f;
+	if (origin == ZL_Origin::BottomLeft) ax = ay = 0;
+	else if (origin == ZL_Origin::TopLeft) { ax = 0; ay = 1; }
+	else if (origin == ZL_Origin::CenterLeft) ax = 0;
+	else if (origin == ZL_Origin::CenterRight) ax = 1;
+	float x = p.x - t->Dimensions.x * ax - (border + 1), y = p.y + 8 - t->Dimensions.y * ay - (border + 1);
+	t->Surface.DrawTo(x, y, x + t->Surface.GetWidth(), y + t->Surface.GetHeight());
+}
+
+//The board doesn't change while playing so its tiles are drawn into render targets of CHUNK_TILES x CHUNK_TILES tiles
+//when they first become visible. A frame only draws the chunks inside the view, so the cost depends on the screen and
+//not on the board size. Chunks on the board edge cover half a tile more for the wall shadows.
+enum { CHUNK_TILES = 32, CHUNK_CACHE = 48 };
+struct SBoardChunk
+{
+	int X, Y;
+	unsigned int LastUsed;
+	float Left, Low, Right, High;
+	ZL_Surface Surface;
+};
+static std::vector<SBoardChunk> BoardChunks;
+
+static void BuildBoardChunk(SBoardChunk& c)
+{
+	int x0 = c.X * CHUNK_TILES, y0 = c.Y * CHUNK_TILES, x1 = MIN(x0 + CHUNK_TILES, Level.Width), y1 = MIN(y0 + CHUNK_TILES, Level.Height);
+	int size = MAX(Level.Width, Level.Height), tilePixels = (size <= CHUNK_TILES ? MIN(64, 2048 / (size + 1)) : 16);
+	c.Left = (x0 ? s(x0) : -.5f);
+	c.Low = (y0 ? s(y0) : -.5f);
+	c.Right = (x1 == Level.Width ? x1 + .5f : s(x1));
+	c.High = (y1 == Level.Height ? y1 + .5f : s(y1));
+	c.Surface = ZL_Surface((int)((c.Right - c.Left) * tilePixels + .5f), (int)((c.High - c.Low) * tilePixels + .5f), true);
+	c.Surface.RenderToBegin(true);
+	ZL_Display::PushOrtho(c.Left, c.Right, c.Low, c.High);
+
+	srfTiles.BatchRenderBegin();
+	for (int y = y0; y != y1; y++)
+		for (int x = x0; x != x1; x++)
+			srfTiles.SetTilesetIndex(TILE_FLOOR).DrawTo(s(x), s(y), s(x+1), s(y+1));
+
+	//shadows of walls in the neighbor chunks reach into this one
+	for (int y = MAX(y0 - 1, 0); y != MIN(y1 + 1, Level.Height); y++)
+		for (int x = MAX(x0 - 1, 0); x != MIN(x1 + 1, Level.Width); x++)
+			if (Level.IsWall(Level.Cell(x, y)))
+				srfTiles.SetTilesetIndex(TILE_SHADOW).DrawTo(s(x)-.05f, s(y)-.05f, s(x)+1.05f, s(y)+1.05f);
+
+	for (int y = y0; y != y1; y++)
+	{
+		for (int x = x0; x != x1; x++)
+		{
+			float fx = s(x), fy = s(y);
+			int cell = Level.Cell(x, y);
+			if (Level.IsWall(cell)) srfTiles.SetTilesetIndex(TILE_WALL).DrawTo(fx, fy, fx+1, fy+1);
+			else if (cell == Level.Goal) srfTiles.SetTilesetIndex(TILE_FLAG).DrawTo(fx, fy, fx+1, fy+1);
+		}
+	}
+	srfTiles.BatchRenderEnd();
+
+	ZL_Display::PopOrtho();
+	c.Surface.RenderToEnd();
+}
+
+//Draws the chunks overlapping the given rectangle (in tiles), the least recently used chunk gets replaced when the
+//cache is full
+static void DrawBoard(float left, float low, float right, float high)
+{
+	static unsigned int frame;
+	frame++;
+	int cx0 = MAX(0, (int)floorf(left)) / CHUNK_TILES, cx1 = MIN(Level.Width - 1, (int)floorf(right)) / CHUNK_TILES;
+	int cy0 = MAX(0, (int)floorf(low)) / CHUNK_TILES, cy1 = MIN(Level.Height - 1, (int)floorf(high)) / CHUNK_TILES;
+	for (int cy = cy0; cy <= cy1; cy++)
+	{
+		for (int cx = cx0; cx <= cx1; cx++)
+		{
+			SBoardChunk* c = NULL;
+			for (SBoardChunk& it : BoardChunks)
+				if (it.X == cx && it.Y == cy) { c = &it; break; }
+			if (!c)
+			{
+				if (BoardChunks.size() < CHUNK_CACHE) { BoardChunks.push_back(SBoardChunk()); c = &BoardChunks.back(); }
+				else for (SBoardChunk& it : BoardChunks) if (!c || it.LastUsed < c->LastUsed) c = &it;
+				c->X = cx;
+				c->Y = cy;
+				BuildBoardChunk(*c);
+			}
+			c->LastUsed = frame;
+			c->Surface.DrawTo(c->Left, c->Low, c->Right, c->High);
+		}
+	}
 }
 
 static void SetState(EGameState state)
@@ -235,10 +241,11 @@ static struct SBot
 {
 	int StartPosX, StartPosY, StartDir, GoalX, GoalY;
 	int PosX, PosY, Dir, NextPosX, NextPosY, NextDir;
-	bool NextBonk, SpeedUp;
+	bool NextBonk, SpeedUp, Turbo;
 	float MoveDelta;
+	int LoopSteps; //set when the instant result found that the program never reaches the goal
 	float Animation;
-	ECommand Commands[10];
+	SProgram Commands;
 	EBotState State;
 	int CommandCount, CommandIndex;
 
@@ -266,8 +273,7 @@ static struct SBot
 			default:;
 		}
 		
-		NextBonk = (NextPosX < 0 || NextPosX >= BoardSize || NextPosY < 0 || NextPosY >= BoardSize);
-		if (!NextBonk) NextBonk = (TILE(NextPosX, NextPosY) == '#');
+		NextBonk = Level.IsWall(Level.Cell(NextPosX, NextPosY));
 	}
 
 	void Program()
@@ -277,6 +283,7 @@ static struct SBot
 		NextDir  = Dir  = StartDir;
 		CommandIndex = 0;
 		MoveDelta = 0;
+		LoopSteps = 0;
 		State = BOT_PROGRAMMING;
 	}
 
@@ -284,37 +291,74 @@ static struct SBot
 	{
 		CommandIndex = CommandCount - 1;
 		RunCommand();
+		LoopSteps = 0;
 		State = BOT_RUNNING;
 	}
 
+	//Computes the outcome of the whole program at once, puts the bot on the goal if it reaches it (the stage clears
+	//when the player moves on or after watching a replay) otherwise stays in programming and remembers after how many
+	//steps the bot starts looping
+	bool RunInstant()
+	{
+		SBotState bot = { Level.Start, Level.StartDir, 0 };
+		SOutcome res = Outcomes.Run(LevelId, Level, Commands, CommandCount, bot);
+		if (!res.Run.Solved) { LoopSteps = res.Run.Steps + res.Run.CycleLength; return false; }
+		NextPosX = PosX = Level.CellX(res.Cell);
+		NextPosY = PosY = Level.CellY(res.Cell);
+		NextDir = Dir = res.Dir;
+		NextBonk = false;
+		MoveDelta = 0;
+		State = BOT_SOLVED;
+		return true;
+	}
+
+	//Runs the solved program again from the start at regular speed, reaching the goal clears the stage as usual
+	void Replay()
+	{
+		SpeedUp = Turbo = false;
+		Program();
+		Run();
+	}
+
 	void SetCommand(ECommand cmd)
 	{
-		Commands[CommandIndex] = cmd;
+		Commands.Set(CommandIndex, cmd);
+		LoopSteps = 0;
 		CommandIndex = ((CommandIndex + 1) % CommandCount);
 		sndSelect.Play();
 	}
 
+	float Speed() const { return (Turbo ? 400.f : (SpeedUp ? 20.f : 5.f)); }
+
+	//Length of the current command in simulation time, a NONE command passes quicker
+	float StepDuration() const { return (Commands[CommandIndex] != CMD_NONE ? 1.f : .3f); }
+
 	void Update()
 	{
 		if (State != BOT_RUNNING) return;
-		float speed = (SpeedUp ? 20.f : 5.f);
-		float elapsed = ZLELAPSEDF(speed);
+		float elapsed = ZLELAPSEDF(Speed());
+
+		//fixed step simulation clock independent of the frame rate, runs as many commands as fit into the elapsed time
+		//and keeps the remainder so Draw can interpolate into the current command
 		MoveDelta += elapsed;
-		if (MoveDelta > (Commands[CommandIndex] != CMD_NONE ? 1.f : .3f))
+		bool moved = false, bonked = false;
+		for (int steps = 0; MoveDelta > StepDuration(); steps++)
 		{
-			MoveDelta = 0;
+			if (steps == 1000) { MoveDelta = 0; break; }
+			MoveDelta -= StepDuration();
 			RunCommand();
 			if (PosX == GoalX && PosY == GoalY)
 			{
 				State = BOT_CLEARED;
 				SetState(GAME_CLEARSTAGE);
 				sndClear.Play();
+				MoveDelta = 0;
+				return;
 			}
-			else if (Commands[CommandIndex] != CMD_NONE)
-			{
-				(NextBonk ? sndBump : sndMove).Play();
-			}
+			if (Commands[CommandIndex] != CMD_NONE) (NextBonk ? bonked : moved) = true;
 		}
+		if (bonked) sndBump.Play();
+		else if (moved) sndMove.Play();
 		if (PosX != GoalX || PosY != GoalY)
 		{
 			if (NextBonk && MoveDelta > .5f) elapsed = -elapsed;
@@ -325,7 +369,7 @@ static struct SBot
 
 	void Draw()
 	{
-		float d = (NextBonk && MoveDelta > .5f ? 1.f - MoveDelta : MoveDelta);
+		float t = MoveDelta / StepDuration(), d = (NextBonk && t > .5f ? 1.f - t : t);
 		d = ZL_Easing::InOutSine(d);
 		float x = ZL_Math::Lerp(s(PosX), s(NextPosX), d), y = ZL_Math::Lerp(s(PosY), s(NextPosY), d), a = ZL_Math::Lerp(s(Dir), s(NextDir), d);
 		int tile = ((((int)(Animation*10)%3)+3)%3);
@@ -335,164 +379,371 @@ static struct SBot
 	}
 } Bot;
 
-#if defined(ZILLALOG)
-static void MakeBoard()
+//Swarm mode (TAB), thousands of bots with random programs on the current board stepped by SBotSwarm. All visible bots
+//with their shadows are drawn in a single batch.
+enum { SWARM_BOTS = 10000 };
+static struct SSwarm
 {
-	int MAPW = 1+2*RAND_INT_RANGE(3,9), MAPH = MAPW;
-	static std::vector<char> buf;
-	buf.resize(1+MAPW*MAPH+1);
-	char* Map = &buf[1];
-	Map[MAPW*MAPH] = '\0';
-	memset(Map, '#', MAPW*MAPH);
+	bool Active;
+	float MoveDelta;
+	SBotSwarm Bots;
+	std::vector<ZL_Color> Colors;
 
-	int playerX = RAND_INT_RANGE(2, MAPW-3);
-	int playerY = RAND_INT_RANGE(2, MAPH-3);
-	Map[playerX*MAPW+playerY] = ' ';
+	void Start(int count, unsigned long long seed)
+	{
+		SRandom rnd(seed, 0);
+		Active = true;
+		MoveDelta = 0;
+		Bots.Start(Level, count, rnd);
+		Colors.resize(count);
+		for (int i = 0; i != count; i++) Colors[i] = ZLHSV(rnd.Int(1000) / 1000.f, .4f, 1);
+	}
+
+	void Update(float speed)
+	{
+		if (!Active) return;
+		MoveDelta += ZLELAPSEDF(speed);
+		for (int steps = 0; MoveDelta > 1.f; steps++)
+		{
+			if (steps == 100) { MoveDelta = 0; break; }
+			MoveDelta -= 1.f;
+			Bots.Step(Level);
+		}
+	}
 
-	for (char empty = 0; empty < 2; empty++)
+	//Only bots inside the given rectangle (in tiles) are drawn
+	void Draw(float left, float low, float right, float high)
 	{
-		int currentx = MAPW/2|1, currenty = MAPH/2|1;
-		for (int y = currenty - 2; y <= currenty + 2; y++)
-			for (int x = currentx - 2; x <= currentx + 2; x++)
-				Map[y*MAPW+x] = empty;
- 
-		REGENERATE:
-		for (int i = 0; i != 100; i++)
+		if (!Active) return;
+		float d = ZL_Easing::InOutSine(MoveDelta);
+		srfBot.SetTilesetIndex((int)(ZLTICKS / 100) % 3);
+		srfBot.BatchRenderBegin(true);
+		for (int pass = 0; pass != 2; pass++)
 		{
-			int oldx = currentx, oldy = currenty;
-			switch (RAND_INT_MAX(3))
+			for (int i = 0; i != Bots.Count; i++)
 			{
-				case 0: if (currentx < MAPW-2) currentx += 2; break;
-				case 1: if (currenty < MAPH-2) currenty += 2; break;
-				case 2: if (currentx >      2) currentx -= 2; break;
-				case 3: if (currenty >      2) currenty -= 2; break;
+				int a = Bots.Pos[i], b = Bots.NextPos[i], turn = ((b & 3) - (a & 3) + 4) % 4;
+				float x = ZL_Math::Lerp(s(Level.CellX(a >> 2)), s(Level.CellX(b >> 2)), d);
+				float y = ZL_Math::Lerp(s(Level.CellY(a >> 2)), s(Level.CellY(b >> 2)), d);
+				if (x < left - 1 || x > right || y < low - 1 || y > high) continue;
+				float angle = ((a & 3) + (turn == 3 ? -d : turn * d)) * PIHALF;
+				if (pass == 0) srfBot.Draw(x+.55f, y+.45f, angle, ZLLUMA(0, .5));
+				else srfBot.Draw(x+.5f, y+.5f, angle, Colors[i]);
 			}
-			if (Map[currenty*MAPW+currentx] == empty) continue;
-			Map[currenty*MAPW+currentx] = empty;
-			Map[((currenty + oldy) / 2)*MAPW+((currentx + oldx) / 2)] = empty;
 		}
- 
-		//check if all cells are visited
-		for (int y = 1; y != MAPH; y += 2)
-			for (int x = 1; x != MAPW; x += 2)
-				if (Map[y*MAPW+x] > ' ') goto REGENERATE;
+		srfBot.BatchRenderEnd();
 	}
+} Swarm;
 
-	for (int i = 0; i != MAPW*MAPH; i++)
-		if (Map[i] < ' ') Map[i] = ' ';
-
-	Board = Map;
-	BoardSize = MAPW;
+//Part of the board shown in the board rectangle, position and view size are in tiles. Boards bigger than the view can
+//be panned by dragging and zoomed with the mouse wheel or page up/down, the camera follows the running bot.
+enum { CAMERA_MIN_VIEW = 4, CAMERA_MAX_VIEW = 128 };
+static struct SCamera
+{
+	float X, Y, View;
+	bool Dragging;
 
-	Bot.StartPosX = playerX;
-	Bot.StartPosY = playerY;
-	Bot.StartDir = RAND_INT_RANGE(0, 3);
+	float MaxView() const { return (float)MIN(MAX(Level.Width, Level.Height), (int)CAMERA_MAX_VIEW); }
 
-	#define SETTILE(X,Y) Map[(BoardSize - 1 - Y) * BoardSize + X]
-	SETTILE(playerX, playerY) = "RULD"[Bot.StartDir];
+	void Reset()
+	{
+		X = Level.Width * .5f;
+		Y = Level.Height * .5f;
+		View = MaxView();
+		Dragging = false;
+	}
 
-	for (int WantMinRange = MAPH; ; WantMinRange--)
+	void Update(const ZL_Rectf& rect, bool input)
 	{
-		for (int retry = 0; retry != 10000; retry++)
+		if (input)
 		{
-			Bot.Program();
-			for (ECommand& c : Bot.Commands) c = (ECommand)RAND_INT_RANGE(CMD_NONE+1, CMD_COUNT-1);
-			Bot.Run();
-
-			for (int step = 0; step != 1000; step++)
+			if (ZL_Input::MouseWheel()) View *= (ZL_Input::MouseWheel() > 0 ? .8f : 1.25f);
+			if (ZL_Input::Down(ZLK_PAGEUP)   || ZL_Input::Down(ZLK_KP_PLUS) ) View *= .8f;
+			if (ZL_Input::Down(ZLK_PAGEDOWN) || ZL_Input::Down(ZLK_KP_MINUS)) View *= 1.25f;
+			if (ZL_Input::Down(ZLK_HOME)) Reset();
+			if (ZL_Input::Down() && rect.Contains(ZL_Input::Pointer())) Dragging = true;
+			if (!ZL_Input::Held()) Dragging = false;
+			if (Dragging)
 			{
-				Bot.RunCommand();
-				if (
-					(((Bot.PosX != Bot.StartPosX) && (Bot.PosY != Bot.StartPosY)) || WantMinRange<=1) &&
-					ZLV(playerX,playerY).GetDistance(ZLV(Bot.PosX,Bot.PosY)) >= WantMinRange)
-				{
-					SETTILE(Bot.PosX, Bot.PosY) = 'G';
-					printf("\n\"%c\"", '0' + Bot.CommandCount);
-					for (int i = 0; i != MAPH; i++)
-					{
-						printf("\n\"%.*s\"", MAPW, Map+i*MAPW);
-					}
-					printf(",\n\n\n");
-
-					Bot.GoalX = Bot.PosX;
-					Bot.GoalY = Bot.PosY;
-					Bot.Program();
-					return;
-				}
+				ZL_Vector d = ZL_Input::PointerDelta() * (View / rect.Width());
+				X -= d.x;
+				Y -= d.y;
 			}
 		}
+		if (Bot.State == BOT_RUNNING && !Dragging)
+		{
+			//keep the running bot inside the middle part of the view
+			float margin = View * .3f;
+			X = ZL_Math::Clamp(X, Bot.PosX + .5f - margin, Bot.PosX + .5f + margin);
+			Y = ZL_Math::Clamp(Y, Bot.PosY + .5f - margin, Bot.PosY + .5f + margin);
+		}
+		View = ZL_Math::Clamp(View, MIN((float)CAMERA_MIN_VIEW, MaxView()), MaxView());
+		X = (View >= Level.Width ? Level.Width * .5f : ZL_Math::Clamp(X, View * .5f, Level.Width - View * .5f));
+		Y = (View >= Level.Height ? Level.Height * .5f : ZL_Math::Clamp(Y, View * .5f, Level.Height - View * .5f));
 	}
-}
+} Camera;
 
-static void Bruteforce(int* out_retries = NULL, int* out_steps = NULL, int* out_commands = NULL)
+//Hints come from the solution with the fewest steps, taken from the solution database or solved by background jobs
+//while the game keeps running. Above SEARCH_MIN_STEPS_COMMANDS that takes too long and the hint is the first solution
+//in program order instead. Each hint puts the first command that differs from it into the program.
+enum EHintState { HINT_NONE, HINT_SOLVING, HINT_READY, HINT_UNSOLVABLE };
+static struct SHint
 {
-	for (int retry = 1; retry != 100000; retry++)
+	EHintState State;
+	SBoard Board; //copy for the jobs as the global one changes with the stage
+	SSolveResult Tasks[SOLVE_TASKS], Result;
+	SSearchResult First; //with more commands than SEARCH_MIN_STEPS_COMMANDS
+	SSharedInt Unsolvable; //set by the first job when the reachability walk proves that no program solves the board
+	SJobQueue Jobs;
+
+	void Reset()
 	{
-		Bot.Program();
-		for (ECommand& c : Bot.Commands) c = (ECommand)RAND_INT_RANGE(CMD_NONE, CMD_COUNT-1);
-		Bot.Run();
+		Jobs.Cancel();
+		State = HINT_NONE;
+	}
 
-		for (int step = 1; step <= 1000; step++)
+	void Request()
+	{
+		if (State == HINT_READY) { Apply(); return; }
+		if (State != HINT_NONE || !BoardFits) return;
+		Board = ::Board;
+		if (SolutionDB.Lookup(Board, Result)) { Finish(); return; }
+		State = HINT_SOLVING;
+		if (Board.CommandCount > SEARCH_MIN_STEPS_COMMANDS)
 		{
-			Bot.RunCommand();
-			if (Bot.PosX == Bot.GoalX && Bot.PosY == Bot.GoalY)
-			{
-				if (!out_retries) printf("Solved after %d tries - takes %d steps\n", retry, step);
-				Bot.Program();
-				if (out_retries) *out_retries = retry;
-				if (out_steps) *out_steps = step;
-				if (out_commands) { *out_commands = 0; for (int i = 0; i != Bot.CommandCount; i++) if (Bot.Commands[i] != CMD_NONE) (*out_commands)++; }
-				return;
-			}
+			Jobs.Start(1, [this](int) { Search(Board, SEARCH_FIRST, First, &Jobs.Stop); });
+			return;
 		}
+		Unsolvable = 0;
+
+		//job 0 is the reachability walk Solve runs first (where it can be exact), solve tasks starting after it proved
+		//the board unsolvable have nothing to do
+		Jobs.Start(SOLVE_TASKS + 1, [this](int i)
+		{
+			if (!i) { Unsolvable = (Board.CommandCount <= REACH_EXACT_COMMANDS && SReachability(Board, true, REACH_MAX_PROGRAMS, &Jobs.Stop).Unsolvable()); return; }
+			if (Unsolvable) ResetSolveResult(Tasks[i - 1]);
+			else SolveTask(Board, i - 1, Tasks[i - 1], &Jobs.Stop);
+		});
 	}
+
+	//Called every frame, takes the result once all jobs are done
+	void Update()
+	{
+		if (State != HINT_SOLVING) return;
+		Jobs.RunSerial();
+		if (!Jobs.Finished()) return;
+		Jobs.Cancel(); //workers have run out of jobs, this only joins them
+		ResetSolveResult(Result);
+		if (Board.CommandCount <= SEARCH_MIN_STEPS_COMMANDS) for (const SSolveResult& t : Tasks) MergeSolveResult(Result, t);
+		else if (First.Solved) { Result.Solutions = 1; Result.MinSteps = First.Steps; Result.MinStepsProgram = First.Program; }
+		Finish();
+	}
+
+	void Finish()
+	{
+		State = (Result.Solutions ? HINT_READY : HINT_UNSOLVABLE);
+		if (State == HINT_READY) Apply();
+	}
+
+	void Apply()
+	{
+		if (Bot.State != BOT_PROGRAMMING) return;
+		for (int i = 0; i != Bot.CommandCount; i++)
+		{
+			if (Bot.Commands[i] == Result.MinStepsProgram[i]) continue;
+			Bot.CommandIndex = i;
+			Bot.SetCommand(Result.MinStepsProgram[i]);
+			return;
+		}
+	}
+} Hint;
+
+//Path preview while programming, updated from the first changed slot whenever the program differs from the last frame.
+//The part that repeats forever is drawn in orange, moves into walls get a red mark and reaching the goal a green ring.
+static SPathTrace Preview;
+static void DrawPreview(float left, float low, float right, float high)
+{
+	static const float dirX[4] = { 1, 0, -1, 0 }, dirY[4] = { 0, 1, 0, -1 };
+	const ZL_Color colPath = ZLRGBA(1, 1, 1, .5f), colLoop = ZLRGBA(1, .6f, .1f, .8f), colBonk = ZLRGBA(1, .2f, .2f, .9f);
+	if (Preview.Update(Level, Bot.Commands, Bot.CommandCount) && (Preview.End == SPathTrace::END_GOAL || Preview.End == SPathTrace::END_LOOP))
+	{
+		//the preview ran the whole program already, keep its outcome for the instant result
+		bool solved = (Preview.End == SPathTrace::END_GOAL);
+		int end = (solved ? Preview.Steps() : Preview.LoopStart);
+		SOutcome res = { { solved, end, (solved ? 0 : Preview.Steps() - end) }, Preview.Path[end] >> 2, Preview.Path[end] & 3 };
+		SBotState start = { Level.Start, Level.StartDir, 0 };
+		Outcomes.Insert(SOutcomeCache::Key(LevelId, Preview.Prog, Preview.Count, start), res);
+	}
+	for (int i = 0; i != Preview.Steps(); i++)
+	{
+		int a = Preview.Path[i], b = Preview.Path[i + 1];
+		float ax = s(Level.CellX(a >> 2)) + .5f, ay = s(Level.CellY(a >> 2)) + .5f;
+		if (ax < left - 1 || ax > right + 1 || ay < low - 1 || ay > high + 1) continue;
+		if ((a >> 2) != (b >> 2))
+		{
+			bool loop = (Preview.LoopStart >= 0 && i >= Preview.LoopStart);
+			ZL_Display::FillWideLine(ax, ay, s(Level.CellX(b >> 2)) + .5f, s(Level.CellY(b >> 2)) + .5f, .08f, (loop ? colLoop : colPath));
+		}
+		else if (Preview.Bonk[i])
+		{
+			int dir = ((a & 3) + (Preview.Prog[i % Preview.Count] == CMD_REVERSE ? 2 : 0)) & 3;
+			ZL_Display::FillCircle(ax + dirX[dir] * .4f, ay + dirY[dir] * .4f, .1f, colBonk);
+		}
+	}
+	if (Preview.End == SPathTrace::END_GOAL)
+		ZL_Display::DrawCircle(s(Level.CellX(Level.Goal)) + .5f, s(Level.CellY(Level.Goal)) + .5f, .4f, ZLRGBA(.2f, 1, .3f, .9f), ZLTRANSPARENT);
+	else if (Preview.End == SPathTrace::END_LOOP)
+		ZL_Display::FillCircle(s(Level.CellX(Preview.Path[Preview.LoopStart] >> 2)) + .5f, s(Level.CellY(Preview.Path[Preview.LoopStart] >> 2)) + .5f, .15f, colLoop);
+}
+
+//Called after Level changed
+static void LoadLevel()
+{
+	BoardFits = Level.ToBoard(Board);
+	LevelId = BoardHash(Level);
+	BoardChunks.clear();
+	Camera.Reset();
+	Swarm.Active = false;
+	Hint.Reset();
+	Preview.Reset();
+}
+
+static ZL_String GetStageName(int idx)
+{
+	if (idx > LastNormalBoard) return ZL_String::format("Bonus Stage %d", idx - LastNormalBoard);
+	return ZL_String::format("Stage %d", idx + 1);
 }
 
-static void BruteStats()
+#if defined(ZILLALOG)
+//Generates a random maze with the solution preloaded into the bot and prints it in the level format, holding shift
+//makes a big rectangular marathon board
+static void MakeBoard()
 {
-	int n, totalRetries = 0, minRetries = 10000000, maxRetries = 0, minSteps = 10000000, maxSteps = 0, minCommands = 10000000, maxCommands = 0;
-	for (n = 0; n != 10; n++)
+	bool large = (ZL_Input::Held(ZLK_LSHIFT) || ZL_Input::Held(ZLK_RSHIFT));
+	int MAPW = 1+2*RAND_INT_RANGE(3,9), MAPH = MAPW;
+	if (large) { MAPW = 1+2*RAND_INT_RANGE(16,127); MAPH = 1+2*RAND_INT_RANGE(16,127); }
+	while (!GenerateMaze(Level, MAPW, MAPH, Bot.CommandCount, (unsigned int)RAND_INT_MAX(0x7FFFFFFF), Bot.Commands)) {}
+
+	printf("\n\"%d\"", Bot.CommandCount);
+	for (int y = MAPH - 1; y >= 0; y--)
 	{
-		int retries, steps, commands;
-		Bruteforce(&retries, &steps, &commands);
-		totalRetries += retries;
-		if (retries < minRetries) minRetries = retries;
-		if (retries > maxRetries) maxRetries = retries;
-		if (steps < minSteps) minSteps = steps;
-		if (steps > maxSteps) maxSteps = steps;
-		if (commands < minCommands) minCommands = commands;
-		if (commands > maxCommands) maxCommands = commands;
+		printf("\n\"");
+		for (int x = 0; x != MAPW; x++)
+		{
+			int cell = Level.Cell(x, y);
+			putchar(cell == Level.Start ? "RULD"[Level.StartDir] : (cell == Level.Goal ? 'G' : (Level.IsWall(cell) ? '#' : ' ')));
+		}
+		printf(MAPW == MAPH ? "\"" : "\\n\"");
 	}
-	printf("Avg Retries: %d - Retries: %d ~ %d - Steps: %d ~ %d - Commands: %d ~ %d\n", totalRetries/n, minRetries, maxRetries, minSteps, maxSteps, minCommands, maxCommands);
+	printf(",\n\n\n");
+
+	LoadLevel();
+	Bot.StartPosX = Level.CellX(Level.Start);
+	Bot.StartPosY = Level.CellY(Level.Start);
+	Bot.StartDir = Level.StartDir;
+	Bot.GoalX = Level.CellX(Level.Goal);
+	Bot.GoalY = Level.CellY(Level.Goal);
+	Bot.Program();
 }
-#endif
 
-static void SetBoard(int idx)
+static void Bruteforce(unsigned long long seed)
 {
-	Board = Boards[idx]+1;
-	BoardSize = (int)(ssqrt((float)strlen(Board))+.4f);
-	BoardIdx = idx;
+	SSharedInt best(BRUTE_MAX_RETRIES);
+	const SBoard& board = Board;
+	ParallelFor(BRUTE_MAX_RETRIES / BRUTE_CHUNK + 1, [&](int chunk)
+	{
+		BruteforceRange(board, seed, MAX(1, chunk * BRUTE_CHUNK), MIN((chunk + 1) * BRUTE_CHUNK, BRUTE_MAX_RETRIES), best);
+	});
+
+	SRunResult run;
+	if (best < BRUTE_MAX_RETRIES && BruteforceRetry(Board, seed, best, Bot.Commands, run))
+		printf("Solved after %d tries - takes %d steps (seed %llu)\n", (int)best, run.Steps, seed);
+	else
+		printf("No solution found after %d tries (seed %llu)\n", BRUTE_MAX_RETRIES, seed);
+	Bot.Program();
+}
 
-	Bot.CommandCount = Boards[idx][0] - '0';
-	memset(Bot.Commands, 0, sizeof(Bot.Commands));
-	Bot.SpeedUp = false;
-	for (int y = 0; y != BoardSize; y++)
+//Boards not in the solution database get solved on the spot
+static void SolveOrLookup(const SBoard& board, SSolveResult& res)
+{
+	if (!SolutionDB.Lookup(board, res)) Solve(board, res);
+}
+
+//The move table is only needed here so it gets built on demand, the game steps the bot on the SMap
+static void PrintGoalStep()
+{
+	static SBoardMoves moves;
+	static SProgramJumps jumps;
+	moves.Build(Board);
+	jumps.Build(moves, Board, Bot.Commands, Bot.CommandCount);
+	SBotState start = { Board.Start, Board.StartDir, 0 };
+	long long step = jumps.FirstGoalStep(start, 1LL << 40);
+	if (step < 0) printf("Program never reaches the goal\n");
+	else printf("Program reaches the goal after %lld steps\n", step);
+}
+
+static void SolveAll()
+{
+	SSolveResult res[BOARD_COUNT];
+	std::vector<SBoard> unknown;
+	std::vector<int> unknownIdx;
+	for (int i = 0; i != BOARD_COUNT; i++)
+		if (!SolutionDB.Lookup(Boards[i], res[i])) { unknown.push_back(Boards[i]); unknownIdx.push_back(i); }
+	std::vector<SSolveResult> solved(unknown.size());
+	Solve(unknown.data(), (int)unknown.size(), solved.data());
+	for (size_t j = 0; j != unknown.size(); j++) res[unknownIdx[j]] = solved[j];
+	for (int i = 0; i != BOARD_COUNT; i++)
+		PrintSolveResult(GetStageName(i), Boards[i].CommandCount, res[i]);
+}
+
+static void BruteStats(const SBoard* boards, int boardCount, int firstStageIdx, unsigned long long seed = BRUTE_STATS_SEED)
+{
+	std::vector<SBruteResult> results(boardCount * BRUTE_SAMPLES);
+	std::vector<char> solved(results.size());
+	ParallelFor((int)results.size(), [&](int i)
 	{
-		for (int x = 0; x != BoardSize; x++)
+		solved[i] = BruteforceSample(boards[i / BRUTE_SAMPLES], SRandom(seed, (unsigned long long)i).Next(), results[i]);
+	});
+
+	for (int b = 0; b != boardCount; b++)
+	{
+		int n = 0, totalRetries = 0, minRetries = 10000000, maxRetries = 0, minSteps = 10000000, maxSteps = 0, minCommands = 10000000, maxCommands = 0;
+		for (int i = b * BRUTE_SAMPLES; i != (b + 1) * BRUTE_SAMPLES; i++)
 		{
-			switch (TILE(x, y))
-			{
-				case 'R': Bot.StartPosX = x; Bot.StartPosY = y; Bot.StartDir = 0; break;
-				case 'U': Bot.StartPosX = x; Bot.StartPosY = y; Bot.StartDir = 1; break;
-				case 'L': Bot.StartPosX = x; Bot.StartPosY = y; Bot.StartDir = 2; break;
-				case 'D': Bot.StartPosX = x; Bot.StartPosY = y; Bot.StartDir = 3; break;
-				case 'G': Bot.GoalX = x, Bot.GoalY = y; break;
-			}
+			if (!solved[i]) continue;
+			const SBruteResult& r = results[i];
+			n++;
+			totalRetries += r.Retries;
+			if (r.Retries < minRetries) minRetries = r.Retries;
+			if (r.Retries > maxRetries) maxRetries = r.Retries;
+			if (r.Steps < minSteps) minSteps = r.Steps;
+			if (r.Steps > maxSteps) maxSteps = r.Steps;
+			if (r.Commands < minCommands) minCommands = r.Commands;
+			if (r.Commands > maxCommands) maxCommands = r.Commands;
 		}
+		if (firstStageIdx >= 0) printf("%s: ", (const char*)GetStageName(firstStageIdx + b));
+		if (!n) { printf("Unsolved in %d samples\n", BRUTE_SAMPLES); continue; }
+		printf("Avg Retries: %d - Retries: %d ~ %d - Steps: %d ~ %d - Commands: %d ~ %d - Solved: %d/%d\n", totalRetries/n, minRetries, maxRetries, minSteps, maxSteps, minCommands, maxCommands, n, BRUTE_SAMPLES);
 	}
+}
+#endif
+
+static void SetBoard(int idx)
+{
+	if (!LevelPack.GetMap(idx, Level)) Level = SMap(Boards[idx % BOARD_COUNT]);
+	BoardIdx = idx;
+	LoadLevel();
+
+	Bot.CommandCount = Level.CommandCount;
+	Bot.Commands = SProgram();
+	Bot.SpeedUp = Bot.Turbo = false;
+	Bot.StartPosX = Level.CellX(Level.Start);
+	Bot.StartPosY = Level.CellY(Level.Start);
+	Bot.StartDir = Level.StartDir;
+	Bot.GoalX = Level.CellX(Level.Goal);
+	Bot.GoalY = Level.CellY(Level.Goal);
 	Bot.Program();
-	StageName = ZL_String::format("Stage %d", idx + 1);
-	if (idx > BOARD_LAST_NORMAL) StageName = ZL_String::format("Bonus Stage %d", idx - BOARD_LAST_NORMAL);
+	StageName = GetStageName(idx);
 
 	BackGradient[0] = RAND_ARRAYELEMENT(GradientColors);
 	BackGradient[1] = RAND_ARRAYELEMENT(GradientColors);
@@ -507,6 +758,14 @@ static void Load()
 	srfTiles = ZL_Surface("Data/gfx.png").SetTilesetClipping(4, 4);
 	srfBot = srfTiles.Clone().SetOrigin(ZL_Origin::Center).SetScale(1/64.f, 1/64.f);
 
+	//the title text is drawn eleven times per frame, render it once in white and tint it when drawing
+	ZL_Vector titleSize = fntBig.GetDimensions("BOTLOOP", 1.35f, 1.35f);
+	srfTitle = ZL_Surface((int)titleSize.x + 2, (int)titleSize.y + 2, true);
+	srfTitle.RenderToBegin(true);
+	fntBig.Draw(s(1), s(1), "BOTLOOP", 1.35f, 1.35f, ZLWHITE, ZL_Origin::BottomLeft);
+	srfTitle.RenderToEnd();
+	srfTitle.SetOrigin(ZL_Origin::Center);
+
 
 	extern TImcSongData imcDataIMCSELECT; sndSelect = ZL_SynthImcTrack::LoadAsSample(&imcDataIMCSELECT);
 	extern TImcSongData imcDataIMCRUN;    sndRun    = ZL_SynthImcTrack::LoadAsSample(&imcDataIMCRUN);
@@ -517,11 +776,30 @@ static void Load()
 	extern TImcSongData imcDataIMCBUMP;   sndBump   = ZL_SynthImcTrack::LoadAsSample(&imcDataIMCBUMP);
 	extern TImcSongData imcDataIMCMUSIC;  imcMusic  = ZL_SynthImcTrack(&imcDataIMCMUSIC);
 
+	if (LoadDataFile(LevelPack, "Data/levels.blp") && LevelPack.Count())
+	{
+		BoardCount = LevelPack.Count();
+		LastNormalBoard = MAX(LevelPack.NormalCount(), 1) - 1;
+	}
+	LoadDataFile(SolutionDB, "Data/solutions.bsdb");
+
 	SetBoard(0);
 	imcMusic.Play();
 }
 
-static void Draw()
+static void RunInstant()
+{
+	if (Bot.RunInstant()) sndClear.Play();
+	else sndBump.Play();
+}
+
+static void ClearSolvedStage()
+{
+	Bot.State = BOT_CLEARED;
+	SetState(GAME_CLEARSTAGE);
+}
+
+static void DrawFrame()
 {
 	if (ZL_Input::Down(ZLK_ESCAPE))
 	{
@@ -555,8 +833,13 @@ static void Draw()
 			if (ZL_Input::Down(ZLK_8)) { SetBoard(7); }
 			if (ZL_Input::Down(ZLK_9)) { SetBoard(8); }
 			if (ZL_Input::Down(ZLK_0)) { SetBoard(9); }
-			if (ZL_Input::Down(ZLK_F)) Bruteforce();
-			if (ZL_Input::Down(ZLK_S)) BruteStats();
+			if (ZL_Input::Down(ZLK_F) && BoardFits) Bruteforce((unsigned int)RAND_INT_MAX(0x7FFFFFFF));
+			if (ZL_Input::Down(ZLK_S) && BoardFits) BruteStats(&Board, 1, -1);
+			if (ZL_Input::Down(ZLK_T)) BruteStats(Boards, BOARD_COUNT, 0);
+			if (ZL_Input::Down(ZLK_X) && BoardFits) { SSolveResult res; SolveOrLookup(Board, res); PrintSolveResult(StageName, Board.CommandCount, res); }
+			if (ZL_Input::Down(ZLK_E)) SolveAll();
+			if (ZL_Input::Down(ZLK_J) && BoardFits) PrintGoalStep();
+			if (ZL_Input::Down(ZLK_K)) printf("Outcome cache: %lld hits - %lld misses\n", (long long)Outcomes.Hits, (long long)Outcomes.Misses);
 			#endif
 
 			if (ZL_Input::Down(ZLK_UP)     || ZL_Input::Down(ZLK_W)    ) Bot.SetCommand(CMD_FORWARD);
@@ -566,17 +849,31 @@ static void Draw()
 			if (ZL_Input::Down(ZLK_DELETE) || ZL_Input::Down(ZLK_SPACE)) Bot.SetCommand(CMD_NONE);
 
 			if (ZL_Input::Down(ZLK_RETURN)) { Bot.Run(); sndRun.Play(); }
+			if (ZL_Input::Down(ZLK_I)) RunInstant();
+			if (ZL_Input::Down(ZLK_H)) Hint.Request();
+			if (ZL_Input::Down(ZLK_TAB))
+			{
+				if (Swarm.Active) Swarm.Active = false;
+				else Swarm.Start(SWARM_BOTS, ZLTICKS);
+			}
 		}
 		else if (Bot.State == BOT_RUNNING)
 		{
 			if (ZL_Input::Down(ZLK_RETURN)) { Bot.Program(); sndReturn.Play(); }
 		}
+		else if (Bot.State == BOT_SOLVED)
+		{
+			if (ZL_Input::Down(ZLK_RETURN)) ClearSolvedStage();
+			if (ZL_Input::Down(ZLK_I) || ZL_Input::Down(ZLK_R)) { Bot.Replay(); sndRun.Play(); }
+			if (ZL_Input::Down(ZLK_BACKSPACE)) { Bot.Program(); sndReturn.Play(); }
+		}
 	}
 
 	if (ZL_Input::Down(ZLK_LSHIFT) || ZL_Input::Down(ZLK_RSHIFT)) Bot.SpeedUp = true;
 	if (ZL_Input::Up(ZLK_LSHIFT) || ZL_Input::Up(ZLK_RSHIFT)) Bot.SpeedUp = false;
 
 	Bot.Update();
+	Swarm.Update(Bot.Speed());
 
 	ZL_Display::FillGradient(0, 0, ZLWIDTH, ZLHEIGHT, BackGradient[0], BackGradient[1], BackGradient[2], BackGradient[3]);
 
@@ -586,49 +883,34 @@ static void Draw()
 
 	ZL_Display::FillRect(boardRect+3, ZLBLACK);
 
-	float x0 = BoardSize * ((       0-boardRect.left) / boardRect.Width());
-	float x1 = BoardSize * (( ZLWIDTH-boardRect.left) / boardRect.Width());
-	float y0 = BoardSize * ((       0-boardRect.low)  / boardRect.Height());
-	float y1 = BoardSize * ((ZLHEIGHT-boardRect.low)  / boardRect.Height());
+	Camera.Update(boardRect, GameState >= GAME_STAGEFADEIN && GameState <= GAME_PLAY);
+	float viewLeft = Camera.X - Camera.View * .5f, viewLow = Camera.Y - Camera.View * .5f, tilesPerPixel = Camera.View / boardRect.Width();
+	float x0 = viewLeft + (       0-boardRect.left) * tilesPerPixel;
+	float x1 = viewLeft + ( ZLWIDTH-boardRect.left) * tilesPerPixel;
+	float y0 = viewLow  + (       0-boardRect.low)  * tilesPerPixel;
+	float y1 = viewLow  + (ZLHEIGHT-boardRect.low)  * tilesPerPixel;
 	ZL_Display::PushOrtho(x0, x1, y0, y1);
+	ZL_Display::SetClip((int)boardRect.left - 3, (int)boardRect.low - 3, (int)boardRect.Width() + 6, (int)boardRect.Height() + 6);
 
-	srfTiles.BatchRenderBegin();
-	srfTiles.SetTilesetIndex(TILE_FLOOR).DrawTo(0, 0, s(BoardSize), s(BoardSize));
-	for (int y = 0; y != BoardSize; y++)
-		for (int x = 0; x != BoardSize; x++)
-			srfTiles.SetTilesetIndex(TILE_FLOOR).DrawTo(s(x), s(y), s(x+1), s(y+1));
-
-	for (int y = 0; y != BoardSize; y++)
-		for (int x = 0; x != BoardSize; x++)
-			if (TILE(x, y) == '#')
-				srfTiles.SetTilesetIndex(TILE_SHADOW).DrawTo(s(x)-.05f, s(y)-.05f, s(x)+1.05f, s(y)+1.05f);
-
-	for (int y = 0; y != BoardSize; y++)
-	{
-		for (int x = 0; x != BoardSize; x++)
-		{
-			float fx = s(x), fy = s(y);
-			switch (TILE(x, y))
-			{
-				case '#': srfTiles.SetTilesetIndex(TILE_WALL).DrawTo(fx, fy, fx+1, fy+1); break;
-				case 'G': srfTiles.SetTilesetIndex(TILE_FLAG).DrawTo(fx, fy, fx+1, fy+1); break;
-			}
-		}
-	}
-	srfTiles.BatchRenderEnd();
+	DrawBoard(viewLeft, viewLow, viewLeft + Camera.View, viewLow + Camera.View);
+	if ((Bot.State == BOT_PROGRAMMING || Bot.State == BOT_SOLVED) && !Swarm.Active) DrawPreview(viewLeft, viewLow, viewLeft + Camera.View, viewLow + Camera.View);
 
 	//for (int i = 0; i <= BoardSize; i++)
 	//	ZL_Display::FillWideLine(0, s(i), s(BoardSize), s(i), .005f, ZLWHITE),
 	//	ZL_Display::FillWideLine(s(i), 0, s(i), s(BoardSize), .005f, ZLWHITE);
 
 	Bot.Draw();
+	Swarm.Draw(viewLeft, viewLow, viewLeft + Camera.View, viewLow + Camera.View);
 
+	ZL_Display::ResetClip();
 	ZL_Display::PopOrtho();
 
+	//the command boxes shrink when a long program would not fit next to the status text
+	float commandPitch = MIN(75.f, (ZLWIDTH - 500) / Bot.CommandCount), commandSize = commandPitch - 10;
 	for (int i = 0; i != Bot.CommandCount; i++)
 	{
-		float x = ZLHALFW + (i - (Bot.CommandCount * .5f)) * 75;
-		ZL_Rectf commandBox(x, 15, x + 65, 15+65);
+		float x = ZLHALFW + (i - (Bot.CommandCount * .5f)) * commandPitch;
+		ZL_Rectf commandBox(x, 15, x + commandSize, 15+commandSize);
 		if (i == Bot.CommandIndex)
 			ZL_Display::FillRect(commandBox+3, ZL_Color::White);
 		srfTiles.SetTilesetIndex(tileCommands[Bot.Commands[i]]).DrawTo(commandBox);
@@ -639,8 +921,10 @@ static void Draw()
 		}
 	}
 
-	float panelLeft = ZLHALFW + (0 - (Bot.CommandCount * .5f)) * 75;
-	fntMain.Draw(panelLeft - 10,15+65*.5f, (Bot.State == BOT_PROGRAMMING ? "Programming" : "Running"), ZL_Origin::CenterRight);
+	float panelLeft = ZLHALFW + (0 - (Bot.CommandCount * .5f)) * commandPitch;
+	if (Swarm.Active) fntMain.Draw(panelLeft - 10,15+commandSize*.5f, ZL_String::format("%d of %d bots cleared", Swarm.Bots.Cleared, Swarm.Bots.Count), ZL_Origin::CenterRight);
+	else if (Bot.LoopSteps) fntMain.Draw(panelLeft - 10,15+commandSize*.5f, ZL_String::format("Loops after %d steps", Bot.LoopSteps), ZL_Origin::CenterRight);
+	else fntMain.Draw(panelLeft - 10,15+commandSize*.5f, (Bot.State == BOT_PROGRAMMING ? "Programming" : (Bot.State == BOT_SOLVED ? "Solved" : "Running")), ZL_Origin::CenterRight);
 
 	for (int i = 0; i != CMD_COUNT; i++)
 	{
@@ -658,11 +942,12 @@ static void Draw()
 		float y = ZLHALFH + 100 - (CMD_COUNT * .5f) * 75 - 1 * 45;
 		ZL_Rectf commandBox(boardRect.right + 15, y, boardRect.right + 15 + 65, y+35);
 		ZL_Display::DrawRect(commandBox, ZLWHITE, ZLBLACK);
-		fntMain.Draw(commandBox.Center()+ZLV(0,9), (Bot.State == BOT_PROGRAMMING ? "START" : "STOP"), .70f, ZL_Origin::Center);
-		fntMain.Draw(commandBox.Center()-ZLV(0,9), "PROGRAM", .70f, ZL_Origin::Center);
+		fntMain.Draw(commandBox.Center()+ZLV(0,9), (Bot.State == BOT_PROGRAMMING ? "START" : (Bot.State == BOT_SOLVED ? "NEXT" : "STOP")), .70f, ZL_Origin::Center);
+		fntMain.Draw(commandBox.Center()-ZLV(0,9), (Bot.State == BOT_SOLVED ? "STAGE" : "PROGRAM"), .70f, ZL_Origin::Center);
 		if (GameState >= GAME_STAGEFADEIN && GameState <= GAME_PLAY && Bot.State != BOT_CLEARED && ZL_Input::Clicked(commandBox))
 		{
 			if (Bot.State == BOT_RUNNING) { Bot.Program(); sndReturn.Play(); }
+			else if (Bot.State == BOT_SOLVED) ClearSolvedStage();
 			else { Bot.Run(); sndRun.Play(); }
 		}
 	}
@@ -671,11 +956,52 @@ static void Draw()
 		float y = ZLHALFH + 100 - (CMD_COUNT * .5f) * 75 - 2 * 45;
 		ZL_Rectf commandBox(boardRect.right + 15, y, boardRect.right + 15 + 65, y+35);
 		ZL_Display::DrawRect(commandBox, ZLWHITE, ZLBLACK);
-		fntMain.Draw(commandBox.Center()+ZLV(0,9), (Bot.SpeedUp ? "HIGH"  : "REGULAR"), .70f, ZL_Origin::Center);
-		fntMain.Draw(commandBox.Center()-ZLV(0,9), (Bot.SpeedUp ? "SPEED" : "SPEED"), .70f, ZL_Origin::Center);
+		fntMain.Draw(commandBox.Center()+ZLV(0,9), (Bot.Turbo ? "TURBO" : (Bot.SpeedUp ? "HIGH"  : "REGULAR")), .70f, ZL_Origin::Center);
+		fntMain.Draw(commandBox.Center()-ZLV(0,9), "SPEED", .70f, ZL_Origin::Center);
 		if (GameState >= GAME_STAGEFADEIN && GameState <= GAME_PLAY && ZL_Input::Clicked(commandBox))
 		{
-			Bot.SpeedUp ^= true;
+			//regular -> high -> turbo -> regular
+			if (Bot.Turbo) Bot.Turbo = Bot.SpeedUp = false;
+			else if (Bot.SpeedUp) Bot.Turbo = true;
+			else Bot.SpeedUp = true;
+		}
+	}
+
+	{
+		float y = ZLHALFH + 100 - (CMD_COUNT * .5f) * 75 - 3 * 45;
+		ZL_Rectf commandBox(boardRect.right + 15, y, boardRect.right + 15 + 65, y+35);
+		ZL_Display::DrawRect(commandBox, ZLWHITE, ZLBLACK);
+		fntMain.Draw(commandBox.Center()+ZLV(0,9), (Bot.State == BOT_SOLVED ? "WATCH" : "INSTANT"), .70f, ZL_Origin::Center);
+		fntMain.Draw(commandBox.Center()-ZLV(0,9), (Bot.State == BOT_SOLVED ? "REPLAY" : "RESULT"), .70f, ZL_Origin::Center);
+		if (GameState >= GAME_STAGEFADEIN && GameState <= GAME_PLAY && Bot.State == BOT_PROGRAMMING && ZL_Input::Clicked(commandBox))
+		{
+			RunInstant();
+		}
+		else if (GameState >= GAME_STAGEFADEIN && GameState <= GAME_PLAY && Bot.State == BOT_SOLVED && ZL_Input::Clicked(commandBox))
+		{
+			Bot.Replay();
+			sndRun.Play();
+		}
+	}
+
+	if (BoardFits)
+	{
+		float y = ZLHALFH + 100 - (CMD_COUNT * .5f) * 75 - 4 * 45;
+		ZL_Rectf commandBox(boardRect.right + 15, y, boardRect.right + 15 + 65, y+35);
+		ZL_Display::DrawRect(commandBox, ZLWHITE, ZLBLACK);
+		if (Hint.State == HINT_SOLVING)
+		{
+			fntMain.Draw(commandBox.Center()+ZLV(0,9), "SOLVING", .70f, ZL_Origin::Center);
+			fntMain.Draw(commandBox.Center()-ZLV(0,9), ZL_String::format("%d%%", (int)(Hint.Jobs.Progress() * 100)), .70f, ZL_Origin::Center);
+		}
+		else
+		{
+			fntMain.Draw(commandBox.Center()+ZLV(0,9), (Hint.State == HINT_UNSOLVABLE ? "NO" : "GET"), .70f, ZL_Origin::Center);
+			fntMain.Draw(commandBox.Center()-ZLV(0,9), (Hint.State == HINT_UNSOLVABLE ? "SOLUTION" : "HINT"), .70f, ZL_Origin::Center);
+		}
+		if (GameState >= GAME_STAGEFADEIN && GameState <= GAME_PLAY && Bot.State == BOT_PROGRAMMING && ZL_Input::Clicked(commandBox))
+		{
+			Hint.Request();
 		}
 	}
 
@@ -706,17 +1032,11 @@ static void Draw()
 			srfBot.Draw(ZLV(x * ZLHALFW*1.7f, 0), x * 20.f, x * 4.f, x * 4.f, ZLLUMA(.5,.5));
 		}
 		ZL_Display::PopMatrix();
-		ZL_Display::PushMatrix();
-		ZL_Display::Translate(ZLV(ZLHALFW, ZLHALFH+100));
+		srfTitle.BatchRenderBegin(true);
 		for (int i = 0; i < 10; i++)
-		{
-			ZL_Display::PushMatrix();
-			ZL_Display::Rotate(RAND_RANGE(-.1f, .1f));
-			fntBig.Draw(0, 0, "BOTLOOP", 1.35f, 1.35f, ZLLUMA(0, .3f), ZL_Origin::Center);
-			ZL_Display::PopMatrix();
-		}
-		ZL_Display::PopMatrix();
-		fntBig.Draw(ZLV(ZLHALFW, ZLHALFH+100), "BOTLOOP", 1.25f, 1.25f, ZLHSV(smod(ZLTICKS*.001f,1),.2f,1), ZL_Origin::Center);
+			srfTitle.Draw(ZLHALFW, ZLHALFH+100, RAND_RANGE(-.1f, .1f), 1, 1, ZLLUMA(0, .3f));
+		srfTitle.Draw(ZLHALFW, ZLHALFH+100, 0, 1.25f/1.35f, 1.25f/1.35f, ZLHSV(smod(ZLTICKS*.001f,1),.2f,1));
+		srfTitle.BatchRenderEnd();
 
 		DrawTextBordered(ZLV(ZLHALFW, ZLHALFH-100), "Click on the command panel on the right side of the screen to program the bot");
 		DrawTextBordered(ZLV(ZLHALFW, ZLHALFH-140), "Alternatively you can use the arrow keys/space/enter");
@@ -756,27 +1076,27 @@ static void Draw()
 		if (a < .5f) a = ZL_Easing::OutCubic(a*2)*.5f;
 		else         a = ZL_Easing::InCubic((a-.5f)*2)*.5f+.5f;
 		DrawTextBordered(ZLV(-100.f+a*(ZLWIDTH+200.f), ZLHALFH), "SUCCESS!", 2);
-		if (a >= .99f) SetState(BoardIdx == BOARD_LAST_NORMAL || BoardIdx == BOARD_LAST_BONUS ? GAME_CLEARALL : GAME_STAGEFADEOUT);
+		if (a >= .99f) SetState(BoardIdx == LastNormalBoard || BoardIdx == BoardCount - 1 ? GAME_CLEARALL : GAME_STAGEFADEOUT);
 	}
 	else if (GameState == GAME_CLEARALL)
 	{
 		GameStateTime += ZLELAPSED;
 		float a = 1 - ZL_Easing::OutCubic(ZL_Math::Clamp01(GameStateTime * .5f));
 		ZL_Display::FillRect(0, 0, ZLWIDTH, ZLHEIGHT, ZLLUMA(0, .5f-a*.5f));
-		DrawTextBordered(ZLV(ZLHALFW+a*(ZLHALFW+200.f), ZLFROMH(180)), (BoardIdx == BOARD_LAST_NORMAL ? "ALL STAGES CLEARED!" : "CONGRATULATION!!"), 2);
+		DrawTextBordered(ZLV(ZLHALFW+a*(ZLHALFW+200.f), ZLFROMH(180)), (IsLastNormalBoard() ? "ALL STAGES CLEARED!" : "CONGRATULATION!!"), 2);
 		DrawTextBordered(ZLV(ZLHALFW+a*(ZLHALFW+500.f), ZLFROMH(250)), "THANK YOU FOR PLAYING", 2);
-		DrawTextBordered(ZLV(ZLHALFW+a*(ZLHALFW+900.f),          250), (BoardIdx == BOARD_LAST_NORMAL ? "Press any key for two bonus stage!" : "Press any key to restart"), 2);
+		DrawTextBordered(ZLV(ZLHALFW+a*(ZLHALFW+900.f),          250), (IsLastNormalBoard() ? "Press any key for the bonus stages!" : "Press any key to restart"), 2);
 		if (a <= .01f && (ZL_Input::KeyDownCount() || ZL_Input::Clicked()))
 		{
-			if (BoardIdx != BOARD_LAST_NORMAL) SetBoard(0);
-			SetState(BoardIdx == BOARD_LAST_NORMAL ? GAME_STAGEFADEOUT : GAME_TITLE);
+			if (!IsLastNormalBoard()) SetBoard(0);
+			SetState(IsLastNormalBoard() ? GAME_STAGEFADEOUT : GAME_TITLE);
 		}
 	}
 	else if (GameState == GAME_STAGEFADEOUT)
 	{
 		GameStateTime += ZLELAPSED;
 		float a = ZL_Math::Clamp01(GameStateTime * 5.f);
-		if (BoardIdx == BOARD_LAST_NORMAL) a = .5f + a * .5f;
+		if (IsLastNormalBoard()) a = .5f + a * .5f;
 		ZL_Display::FillRect(0, 0, ZLWIDTH, ZLHEIGHT, ZLLUMA(0, a));
 		if (a >= .99f)
 		{
@@ -787,6 +1107,53 @@ static void Draw()
 	}
 }
 
+//Redraw on demand, while programming and nothing happens for a second the frame is captured into a render target and
+//shown at a low frame rate until there is input again (music plays independently of the frame rate)
+enum { IDLE_AFTER_TICKS = 1000, IDLE_FPS = 10, ACTIVE_FPS = 60 };
+static ZL_Surface srfIdleFrame;
+static unsigned int ActiveTicks;
+static float IdleWidth, IdleHeight;
+static bool Idle;
+
+static bool IsActiveFrame()
+{
+	if (GameState != GAME_PLAY || (Bot.State != BOT_PROGRAMMING && Bot.State != BOT_SOLVED) || Swarm.Active || Hint.State == HINT_SOLVING) return true;
+	if (ZL_Input::KeyDownCount() || ZL_Input::Up(ZLK_LSHIFT) || ZL_Input::Up(ZLK_RSHIFT)) return true;
+	if (ZL_Input::Down() || ZL_Input::Up() || ZL_Input::Held() || ZL_Input::MouseWheel()) return true;
+	return (ZLWIDTH != IdleWidth || ZLHEIGHT != IdleHeight);
+}
+
+static void Draw()
+{
+	if (IsActiveFrame())
+	{
+		ActiveTicks = ZLTICKS;
+		if (Idle) { Idle = false; ZL_Application::SetFpsLimit(ACTIVE_FPS); }
+	}
+	else if (Idle)
+	{
+		srfIdleFrame.DrawTo(0, 0, ZLWIDTH, ZLHEIGHT);
+		return;
+	}
+
+	bool capture = (!Idle && ZLTICKS - ActiveTicks > IDLE_AFTER_TICKS);
+	if (capture)
+	{
+		srfIdleFrame = ZL_Surface((int)ZLWIDTH, (int)ZLHEIGHT);
+		srfIdleFrame.RenderToBegin(true);
+	}
+	DrawFrame();
+	IdleWidth = ZLWIDTH;
+	IdleHeight = ZLHEIGHT;
+	if (capture)
+	{
+		srfIdleFrame.RenderToEnd();
+		srfIdleFrame.DrawTo(0, 0, ZLWIDTH, ZLHEIGHT);
+		Idle = true;
+		ZL_Application::SetFpsLimit(IDLE_FPS);
+	}
+}
+
 static struct sBotloop : public ZL_Application
 {
 	sBotloop() : ZL_Application(60) { }
@@ -804,6 +1171,7 @@ static struct sBotloop : public ZL_Application
 
 	virtual void AfterFrame()
 	{
+		Hint.Update();
 		::Draw();
 	}
 } Botloop;
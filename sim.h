@@ -0,0 +1,1596 @@
+/*
+  BOTLOOP
+  Copyright (C) 2020 Bernhard Schelling
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef _BOTLOOP_SIM_
+#define _BOTLOOP_SIM_
+
+//Bot simulation and solvers shared by the game and the headless tools, must not depend on ZillaLib
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <functional>
+#include <unordered_map>
+#include <list>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+#if !defined(__wasm__) && !defined(__EMSCRIPTEN__)
+#define BOT_THREADS
+#include <thread>
+#include <atomic>
+#include <mutex>
+#endif
+
+enum ECommand { CMD_NONE, CMD_FORWARD, CMD_REVERSE, CMD_TURNLEFT, CMD_TURNRIGHT, CMD_COUNT };
+
+//Program with 3 bits per command in a single word. Slot 0 is in the highest bits so comparing the words compares the
+//programs in slot order (the program order of the solvers), unused slots stay CMD_NONE.
+struct SProgram
+{
+	enum { BITS = 3, MASK = 7, MAX_COMMANDS = 21 };
+	unsigned long long Bits;
+
+	static int Shift(int slot) { return (MAX_COMMANDS - 1 - slot) * BITS; }
+	ECommand operator[](int slot) const { return (ECommand)((Bits >> Shift(slot)) & MASK); }
+	void Set(int slot, ECommand cmd) { Bits = (Bits & ~((unsigned long long)MASK << Shift(slot))) | ((unsigned long long)cmd << Shift(slot)); }
+	void ClearFrom(int slot) { if (slot < MAX_COMMANDS) Bits &= ~((((unsigned long long)MASK + 1) << Shift(slot)) - 1); }
+	bool operator<(const SProgram& o) const { return Bits < o.Bits; }
+	bool operator==(const SProgram& o) const { return Bits == o.Bits; }
+	bool operator!=(const SProgram& o) const { return Bits != o.Bits; }
+
+	int Commands(int count) const
+	{
+		int n = 0;
+		for (int i = 0; i != count; i++) if ((*this)[i] != CMD_NONE) n++;
+		return n;
+	}
+};
+
+//Length of the command count at the start of a level string
+static constexpr int BoardDefDigits(const char* def)
+{
+	int n = 0;
+	while (def[n] >= '0' && def[n] <= '9') n++;
+	return n;
+}
+
+//Board layout parsed at compile time from the level strings below (the command count as a number, then one character
+//per tile, top row first). Each row is one word of wall bits with a wall border around the board so
+//moving the bot never needs a bounds check.
+struct SBoard
+{
+	enum { PITCH = 32, MAX_SIZE = PITCH - 2 };
+	unsigned int Walls[PITCH];
+	unsigned char Width, Height, CommandCount, StartDir;
+	unsigned short Start, Goal;
+
+	constexpr SBoard() : Walls(), Width(0), Height(0), CommandCount(0), StartDir(0), Start(0), Goal(0) { }
+	constexpr SBoard(const char* def) : SBoard()
+	{
+		int digits = BoardDefDigits(def), len = 0, size = 0, count = 0;
+		for (int i = 0; i != digits; i++) count = count * 10 + (def[i] - '0');
+		def += digits;
+		while (def[len]) len++;
+		while ((size + 1) * (size + 1) <= len) size++;
+		Width = Height = (unsigned char)size;
+		CommandCount = (unsigned char)count;
+		for (int row = 0; row != PITCH; row++)
+			Walls[row] = (row == 0 || row > size ? ~0u : ((~0u << (size + 1)) | 1u));
+		for (int y = 0; y != size; y++)
+		{
+			for (int x = 0; x != size; x++)
+			{
+				switch (def[(size - 1 - y) * size + x])
+				{
+					case '#': Walls[y + 1] |= (1u << (x + 1)); break;
+					case 'R': Start = (unsigned short)Cell(x, y); StartDir = 0; break;
+					case 'U': Start = (unsigned short)Cell(x, y); StartDir = 1; break;
+					case 'L': Start = (unsigned short)Cell(x, y); StartDir = 2; break;
+					case 'D': Start = (unsigned short)Cell(x, y); StartDir = 3; break;
+					case 'G': Goal = (unsigned short)Cell(x, y); break;
+				}
+			}
+		}
+	}
+
+	static constexpr int Cell(int x, int y) { return (y + 1) * PITCH + x + 1; }
+	static constexpr int CellX(int cell) { return cell % PITCH - 1; }
+	static constexpr int CellY(int cell) { return cell / PITCH - 1; }
+	static constexpr int Forward(int dir) { return (dir & 1 ? PITCH : 1) * (dir & 2 ? -1 : 1); } //cell offset of one step in direction 0 to 3
+	bool IsWall(int cell) const { return (Walls[cell / PITCH] >> (cell % PITCH)) & 1; }
+	int Cells() const { return PITCH * PITCH; }
+};
+
+//Gets the dimensions of a level string (command count followed by the tiles, top row first). Rows can be separated by
+//line breaks which allows rectangular boards, without any the board has to be square.
+static inline const char* ParseBoardDef(const char* def, int& width, int& height)
+{
+	width = height = 0;
+	def += BoardDefDigits(def);
+	if (!strchr(def, '\n'))
+	{
+		int len = (int)strlen(def);
+		while ((width + 1) * (width + 1) <= len) width++;
+		height = width;
+		return (width * width != len ? "board is not square" : NULL);
+	}
+	for (const char* p = def + strspn(def, "\r\n"); *p;)
+	{
+		int len = (int)strcspn(p, "\r\n");
+		if (height && len != width) return "board rows have different lengths";
+		width = len;
+		height++;
+		p += len;
+		p += strspn(p, "\r\n");
+	}
+	return NULL;
+}
+
+struct SBotState
+{
+	int Cell, Dir, Index;
+	bool operator==(const SBotState& o) const { return Cell == o.Cell && Dir == o.Dir && Index == o.Index; }
+	bool operator!=(const SBotState& o) const { return !(*this == o); }
+
+	template <typename TBoard> void Move(const TBoard& board, ECommand cmd)
+	{
+		switch (cmd)
+		{
+			case CMD_FORWARD:   if (!board.IsWall(Cell + board.Forward(Dir))) Cell += board.Forward(Dir); break;
+			case CMD_REVERSE:   if (!board.IsWall(Cell - board.Forward(Dir))) Cell -= board.Forward(Dir); break;
+			case CMD_TURNLEFT:  Dir = ((Dir + 1) & 3); break;
+			case CMD_TURNRIGHT: Dir = ((Dir + 3) & 3); break;
+			default:;
+		}
+	}
+
+	template <typename TBoard> void Step(const TBoard& board, const SProgram& prog, int count)
+	{
+		Move(board, prog[Index]);
+		if (++Index == count) Index = 0;
+	}
+};
+
+//Board of any size up to MAX_SIZE in both directions with the same layout as SBoard (one wall bit per cell, a wall
+//border, rows of Pitch() cells) but with the row pitch picked at run time and the wall bits on the heap. Used by the
+//game to play big generated levels, boards that fit into an SBoard get converted for the solvers.
+struct SMap
+{
+	enum { MAX_SIZE = 1024 };
+	int Width, Height, Shift, CommandCount, StartDir, Start, Goal;
+	std::vector<unsigned int> Walls;
+
+	SMap() : Width(0), Height(0), Shift(5), CommandCount(0), StartDir(0), Start(0), Goal(0) { }
+
+	explicit SMap(const SBoard& board) : SMap()
+	{
+		Reset(board.Width, board.Height);
+		for (int y = 0; y != Height; y++)
+			for (int x = 0; x != Width; x++)
+				if (board.IsWall(SBoard::Cell(x, y))) SetWall(x, y, true);
+		CommandCount = board.CommandCount;
+		StartDir = board.StartDir;
+		Start = Cell(SBoard::CellX(board.Start), SBoard::CellY(board.Start));
+		Goal = Cell(SBoard::CellX(board.Goal), SBoard::CellY(board.Goal));
+	}
+
+	//Parses a level string that passed CheckBoardDef
+	explicit SMap(const char* def) : SMap()
+	{
+		int width, height, i = 0;
+		ParseBoardDef(def, width, height);
+		Reset(width, height);
+		CommandCount = atoi(def);
+		for (const char* p = def + BoardDefDigits(def); *p; p++)
+		{
+			if (*p == '\r' || *p == '\n') continue;
+			int x = i % width, y = height - 1 - i / width;
+			i++;
+			switch (*p)
+			{
+				case '#': SetWall(x, y, true); break;
+				case 'R': Start = Cell(x, y); StartDir = 0; break;
+				case 'U': Start = Cell(x, y); StartDir = 1; break;
+				case 'L': Start = Cell(x, y); StartDir = 2; break;
+				case 'D': Start = Cell(x, y); StartDir = 3; break;
+				case 'G': Goal = Cell(x, y); break;
+			}
+		}
+	}
+
+	//Empty board of the given size inside a wall border
+	void Reset(int width, int height)
+	{
+		Width = width;
+		Height = height;
+		for (Shift = 5; (1 << Shift) < width + 2; Shift++) {}
+		Walls.assign((size_t)(height + 2) << (Shift - 5), ~0u);
+		for (int y = 0; y != height; y++)
+			for (int x = 0; x != width; x++)
+				SetWall(x, y, false);
+	}
+
+	//Copies the board into an SBoard if it is small enough for the solvers, the cell numbers stay the same
+	bool ToBoard(SBoard& out) const
+	{
+		if (Width > SBoard::MAX_SIZE || Height > SBoard::MAX_SIZE) return false;
+		out = SBoard();
+		for (int row = 0; row != SBoard::PITCH; row++) out.Walls[row] = (row < Height + 2 ? Walls[row] : ~0u);
+		out.Width = (unsigned char)Width;
+		out.Height = (unsigned char)Height;
+		out.CommandCount = (unsigned char)CommandCount;
+		out.StartDir = (unsigned char)StartDir;
+		out.Start = (unsigned short)Start;
+		out.Goal = (unsigned short)Goal;
+		return true;
+	}
+
+	int Pitch() const { return 1 << Shift; }
+	int Cell(int x, int y) const { return ((y + 1) << Shift) + x + 1; }
+	int CellX(int cell) const { return (cell & (Pitch() - 1)) - 1; }
+	int CellY(int cell) const { return (cell >> Shift) - 1; }
+	int Forward(int dir) const { return (dir & 1 ? Pitch() : 1) * (dir & 2 ? -1 : 1); }
+	bool IsWall(int cell) const { return (Walls[cell >> 5] >> (cell & 31)) & 1; }
+	int Cells() const { return (int)Walls.size() * 32; }
+	void SetWall(int x, int y, bool wall)
+	{
+		int cell = Cell(x, y);
+		if (wall) Walls[cell >> 5] |= (1u << (cell & 31));
+		else Walls[cell >> 5] &= ~(1u << (cell & 31));
+	}
+
+	//Position packed as cell<<2|dir after a command, like SBoardMoves::Next but computed from the walls
+	int Move(int pos, ECommand cmd) const
+	{
+		SBotState bot = { pos >> 2, pos & 3, 0 };
+		bot.Move(*this, cmd);
+		return (bot.Cell << 2) | bot.Dir;
+	}
+};
+
+//Path of a program from the start up to the goal or the first repeated state, kept up to date while the program gets
+//edited. Changing a slot only invalidates the path from the step where that slot first ran, the prefix before it and
+//its visited states are kept and the simulation continues from there.
+struct SPathTrace
+{
+	enum { MAX_STEPS = 100000 };
+	enum EEnd { END_NONE, END_GOAL, END_LOOP, END_LIMIT };
+	std::vector<int> Path; //position (cell<<2|dir) before every step, Path[0] is the start
+	std::vector<bool> Bonk; //move commands of every step that ran into a wall
+	std::unordered_map<unsigned long long, int> Seen; //state (position and slot) to the step it was first at
+	int FirstRun[SProgram::MAX_COMMANDS]; //step where each slot ran first or -1
+	int Count, LoopStart;
+	EEnd End;
+	SProgram Prog;
+
+	SPathTrace() : Count(0), LoopStart(-1), End(END_NONE) { }
+
+	void Reset() { Path.clear(); Count = 0; }
+
+	//Returns true if the program or the board changed
+	bool Update(const SMap& map, const SProgram& prog, int count)
+	{
+		if (Path.empty() || count != Count)
+		{
+			Path.assign(1, (map.Start << 2) | map.StartDir);
+			Bonk.clear();
+			Seen.clear();
+			for (int& f : FirstRun) f = -1;
+			Count = count;
+			Prog = prog;
+			Extend(map);
+			return true;
+		}
+		if (prog == Prog) return false;
+
+		//the highest differing bit is in the first changed slot
+		unsigned long long diff = prog.Bits ^ Prog.Bits;
+		int high = 63;
+		while (!(diff >> high)) high--;
+		int slot = SProgram::MAX_COMMANDS - 1 - high / SProgram::BITS, from = FirstRun[slot];
+		Prog = prog;
+		if (from < 0) return true; //slot never ran, the path stays the same
+
+		for (int i = from; i != (int)Path.size(); i++)
+		{
+			std::unordered_map<unsigned long long, int>::iterator it = Seen.find(Key(Path[i], i));
+			if (it != Seen.end() && it->second == i) Seen.erase(it);
+		}
+		for (int& f : FirstRun) if (f >= from) f = -1;
+		Path.resize(from + 1);
+		Bonk.resize(from);
+		Extend(map);
+		return true;
+	}
+
+	unsigned long long Key(int pos, int step) const { return (unsigned long long)pos * Count + step % Count; }
+	int Steps() const { return (int)Path.size() - 1; }
+
+private:
+	void Extend(const SMap& map)
+	{
+		LoopStart = -1;
+		for (;;)
+		{
+			int step = Steps(), pos = Path.back(), slot = step % Count;
+			if (step && (pos >> 2) == map.Goal) { End = END_GOAL; return; }
+			std::pair<std::unordered_map<unsigned long long, int>::iterator, bool> ins = Seen.insert(std::make_pair(Key(pos, step), step));
+			if (!ins.second) { End = END_LOOP; LoopStart = ins.first->second; return; }
+			if (step == MAX_STEPS) { End = END_LIMIT; return; }
+			if (FirstRun[slot] < 0) FirstRun[slot] = step;
+			ECommand cmd = Prog[slot];
+			int next = map.Move(pos, cmd);
+			Bonk.push_back((cmd == CMD_FORWARD || cmd == CMD_REVERSE) && (next >> 2) == (pos >> 2));
+			Path.push_back(next);
+		}
+	}
+};
+
+//Checks a level string before it gets parsed into an SMap at run time, returns NULL if it is valid
+static inline const char* CheckBoardDef(const char* def)
+{
+	int digits = BoardDefDigits(def), width, height, starts = 0, goals = 0;
+	if (!digits || digits > 2 || atoi(def) < 1 || atoi(def) > SProgram::MAX_COMMANDS) return "command count must be a number from 1 to 21";
+	if (const char* err = ParseBoardDef(def, width, height)) return err;
+	if (width < 3 || height < 3 || width > SMap::MAX_SIZE || height > SMap::MAX_SIZE) return "board size out of range";
+	for (const char* p = def + digits; *p; p++)
+	{
+		if (*p == '\r' || *p == '\n') continue;
+		if (strchr("RULD", *p)) starts++;
+		else if (*p == 'G') goals++;
+		else if (*p != '#' && *p != ' ') return "invalid tile character";
+	}
+	if (starts != 1) return "board needs exactly one start (R, U, L or D)";
+	if (goals != 1) return "board needs exactly one goal (G)";
+	return NULL;
+}
+
+struct SRunResult
+{
+	bool Solved;
+	int Steps;       //steps until the goal is reached, or until the first state of the cycle when not solved
+	int CycleLength; //0 when solved
+};
+
+//The bot state is finite so every program either reaches the goal or ends up repeating a state and loops forever.
+//Uses Brent's cycle detection which needs no memory and finds the cycle within a few times its length.
+template <typename TBoard> static inline SRunResult RunProgram(const TBoard& board, const SProgram& prog, int count, const SBotState& start, int startStep = 0)
+{
+	SRunResult res = { true, startStep, 0 };
+	SBotState tortoise = start, hare = start;
+	for (int power = 1, lam = 0; ; lam++)
+	{
+		if (lam == power) { tortoise = hare; power *= 2; lam = 0; }
+		hare.Step(board, prog, count);
+		res.Steps++;
+		if (hare.Cell == board.Goal) return res;
+		if (hare == tortoise) { res.CycleLength = lam + 1; break; }
+	}
+
+	//find the start of the cycle by running two bots one cycle length apart
+	res.Solved = false;
+	res.Steps = startStep;
+	tortoise = hare = start;
+	for (int i = 0; i != res.CycleLength; i++) hare.Step(board, prog, count);
+	for (; tortoise != hare; res.Steps++) { tortoise.Step(board, prog, count); hare.Step(board, prog, count); }
+	return res;
+}
+
+//Result of every command in every cell and direction of a board, so a bot step is a single lookup. Positions are packed
+//as cell<<2|dir and a move into a wall keeps the cell unchanged like the bonk in the game.
+struct SBoardMoves
+{
+	enum { STATES = SBoard::PITCH * SBoard::PITCH * 4 };
+	unsigned short Next[STATES][CMD_COUNT];
+
+	static int Pack(int cell, int dir) { return (cell << 2) | (dir & 3); }
+
+	void Build(const SBoard& board)
+	{
+		for (int pos = 0; pos != STATES; pos++)
+		{
+			for (int c = CMD_NONE; c != CMD_COUNT; c++)
+			{
+				SBotState bot = { pos >> 2, pos & 3, 0 };
+				if (!board.IsWall(bot.Cell)) bot.Move(board, (ECommand)c);
+				Next[pos][c] = (unsigned short)Pack(bot.Cell, bot.Dir);
+			}
+		}
+	}
+
+	void Step(SBotState& bot, const SProgram& prog, int count) const
+	{
+		int pos = Next[Pack(bot.Cell, bot.Dir)][prog[bot.Index]];
+		bot.Cell = pos >> 2;
+		bot.Dir = pos & 3;
+		if (++bot.Index == count) bot.Index = 0;
+	}
+};
+
+//Binary lifting over full passes through a program, level N maps a position at the start of the loop to the position
+//2^N passes later and flags if the goal was entered on the way. Answers where the bot is after K steps and when it
+//first enters the goal in O(log K) lookups.
+struct SProgramJumps
+{
+	enum { LEVELS = 32, GOAL_FLAG = 0x8000 };
+	const SBoardMoves* Moves;
+	SProgram Prog;
+	int Count, Goal;
+	unsigned short Jump[LEVELS][SBoardMoves::STATES];
+
+	void Build(const SBoardMoves& moves, const SBoard& board, const SProgram& prog, int count)
+	{
+		Moves = &moves;
+		Prog = prog;
+		Count = count;
+		Goal = board.Goal;
+		for (int pos = 0; pos != SBoardMoves::STATES; pos++)
+		{
+			SBotState bot = { pos >> 2, pos & 3, 0 };
+			int flag = 0;
+			for (int i = 0; i != count; i++) { moves.Step(bot, Prog, count); if (bot.Cell == Goal) flag = GOAL_FLAG; }
+			Jump[0][pos] = (unsigned short)(SBoardMoves::Pack(bot.Cell, bot.Dir) | flag);
+		}
+		for (int lvl = 1; lvl != LEVELS; lvl++)
+		{
+			for (int pos = 0; pos != SBoardMoves::STATES; pos++)
+			{
+				int half = Jump[lvl - 1][pos], full = Jump[lvl - 1][half & ~GOAL_FLAG];
+				Jump[lvl][pos] = (unsigned short)(full | (half & GOAL_FLAG));
+			}
+		}
+	}
+
+	//Position after the given number of steps, ignoring that the game stops the bot at the goal
+	SBotState After(SBotState bot, long long steps) const
+	{
+		for (; steps && bot.Index; steps--) Moves->Step(bot, Prog, Count);
+		long long passes = steps / Count;
+		int pos = SBoardMoves::Pack(bot.Cell, bot.Dir);
+		for (int lvl = 0; lvl != LEVELS && passes; lvl++, passes >>= 1)
+			if (passes & 1) pos = Jump[lvl][pos] & ~GOAL_FLAG;
+		bot.Cell = pos >> 2;
+		bot.Dir = pos & 3;
+		for (steps %= Count; steps; steps--) Moves->Step(bot, Prog, Count);
+		return bot;
+	}
+
+	//Number of steps until the bot first enters the goal, or -1 if it does not happen within maxSteps (a position
+	//repeats after at most STATES passes so anything beyond 2^LEVELS passes can never reach it)
+	long long FirstGoalStep(SBotState bot, long long maxSteps) const
+	{
+		long long steps = 0;
+		for (; steps != maxSteps && bot.Index; ) { Moves->Step(bot, Prog, Count); if (++steps, bot.Cell == Goal) return steps; }
+		long long passes = (maxSteps - steps) / Count;
+		int pos = SBoardMoves::Pack(bot.Cell, bot.Dir);
+		for (int lvl = LEVELS - 1; lvl >= 0; lvl--)
+		{
+			if ((passes >> lvl) == 0 || (Jump[lvl][pos] & GOAL_FLAG)) continue;
+			pos = Jump[lvl][pos];
+			passes -= (1LL << lvl);
+			steps += ((long long)Count << lvl);
+		}
+		bot.Cell = pos >> 2;
+		bot.Dir = pos & 3;
+		for (int i = 0; i != Count && steps != maxSteps; i++) { Moves->Step(bot, Prog, Count); if (++steps, bot.Cell == Goal) return steps; }
+		return -1;
+	}
+};
+
+//Simulates up to LANES programs in lockstep. Each lane holds its state packed as cell<<7|dir<<5|index so a step is a few
+//integer operations per lane, which with AVX2 run on all lanes at once (including the wall test by gathering the row
+//words). Lanes stop when the bot enters a cell set in the target mask or when Brent's cycle detection finds a repeated
+//state. Run() returns as soon as any lane finished so the caller can refill it while the others keep running.
+struct SBotBatch
+{
+	enum { LANES = 8, MAX_COMMANDS = SProgram::MAX_COMMANDS, RESULT_TARGET = 1, RESULT_LOOP = 2 };
+	const unsigned int *Walls, *Targets;
+	alignas(32) int State[LANES], Tortoise[LANES], Power[LANES], Lam[LANES], Steps[LANES], Count[LANES], Active[LANES], Result[LANES];
+	alignas(32) int Program[LANES * MAX_COMMANDS]; //commands unpacked for the gather
+	SProgram Packed[LANES];
+	long long Tag[LANES];
+
+	//Idle lanes still take part in the gathers so their state must stay a valid cell
+	SBotBatch(const unsigned int* walls, const unsigned int* targets) : Walls(walls), Targets(targets), State(), Tortoise(), Power(), Lam(), Steps(), Count(), Active(), Result(), Program() {}
+
+	int FreeLane() const { for (int i = 0; i != LANES; i++) if (!Active[i]) return i; return -1; }
+	bool Busy() const { for (int i = 0; i != LANES; i++) if (Active[i]) return true; return false; }
+	int Cell(int lane) const { return State[lane] >> 7; }
+	int CycleLength(int lane) const { return (Result[lane] == RESULT_LOOP ? Lam[lane] : 0); }
+	const SProgram& Commands(int lane) const { return Packed[lane]; }
+
+	void Add(int lane, const SProgram& prog, int count, const SBotState& start, int startStep, long long tag)
+	{
+		for (int i = 0; i != count; i++) Program[lane * MAX_COMMANDS + i] = prog[i];
+		Packed[lane] = prog;
+		State[lane] = Tortoise[lane] = (start.Cell << 7) | (start.Dir << 5) | start.Index;
+		Power[lane] = 1;
+		Lam[lane] = Result[lane] = 0;
+		Steps[lane] = startStep;
+		Count[lane] = count;
+		Tag[lane] = tag;
+		Active[lane] = -1;
+	}
+
+	//Returns a bit mask of the lanes that finished, Result/Steps/CycleLength/Cell tell the outcome
+	unsigned int Run()
+	{
+		if (!Busy()) return 0;
+		for (unsigned int finished;;) if ((finished = Step()) != 0) return finished;
+	}
+
+	#if defined(__AVX2__)
+	unsigned int Step()
+	{
+		const __m256i one = _mm256_set1_epi32(1), two = _mm256_set1_epi32(2), three = _mm256_set1_epi32(3), c31 = _mm256_set1_epi32(31);
+		const __m256i laneBase = _mm256_setr_epi32(0, MAX_COMMANDS, 2*MAX_COMMANDS, 3*MAX_COMMANDS, 4*MAX_COMMANDS, 5*MAX_COMMANDS, 6*MAX_COMMANDS, 7*MAX_COMMANDS);
+		__m256i act = _mm256_load_si256((const __m256i*)Active), st = _mm256_load_si256((const __m256i*)State);
+		__m256i tor = _mm256_load_si256((const __m256i*)Tortoise), pow = _mm256_load_si256((const __m256i*)Power), lam = _mm256_load_si256((const __m256i*)Lam);
+
+		__m256i reset = _mm256_and_si256(_mm256_cmpeq_epi32(lam, pow), act);
+		tor = _mm256_blendv_epi8(tor, st, reset);
+		pow = _mm256_blendv_epi8(pow, _mm256_add_epi32(pow, pow), reset);
+		lam = _mm256_andnot_si256(reset, lam);
+
+		__m256i cell = _mm256_srli_epi32(st, 7), dir = _mm256_and_si256(_mm256_srli_epi32(st, 5), three), idx = _mm256_and_si256(st, c31);
+		__m256i cmd = _mm256_i32gather_epi32(Program, _mm256_add_epi32(laneBase, idx), 4);
+		__m256i fwd = _mm256_blendv_epi8(one, _mm256_set1_epi32(SBoard::PITCH), _mm256_cmpeq_epi32(_mm256_and_si256(dir, one), one));
+		__m256i neg = _mm256_cmpeq_epi32(_mm256_and_si256(dir, two), two);
+		fwd = _mm256_sub_epi32(_mm256_xor_si256(fwd, neg), neg);
+		__m256i mv = _mm256_sub_epi32(_mm256_and_si256(_mm256_cmpeq_epi32(cmd, _mm256_set1_epi32(CMD_FORWARD)), fwd), _mm256_and_si256(_mm256_cmpeq_epi32(cmd, _mm256_set1_epi32(CMD_REVERSE)), fwd));
+		__m256i ncell = _mm256_add_epi32(cell, mv);
+		__m256i wall = _mm256_and_si256(_mm256_srlv_epi32(_mm256_i32gather_epi32((const int*)Walls, _mm256_srli_epi32(ncell, 5), 4), _mm256_and_si256(ncell, c31)), one);
+		cell = _mm256_blendv_epi8(ncell, cell, _mm256_cmpeq_epi32(wall, one));
+		dir = _mm256_sub_epi32(dir, _mm256_cmpeq_epi32(cmd, _mm256_set1_epi32(CMD_TURNLEFT)));
+		dir = _mm256_and_si256(_mm256_add_epi32(dir, _mm256_cmpeq_epi32(cmd, _mm256_set1_epi32(CMD_TURNRIGHT))), three);
+		idx = _mm256_add_epi32(idx, one);
+		idx = _mm256_andnot_si256(_mm256_cmpeq_epi32(idx, _mm256_load_si256((const __m256i*)Count)), idx);
+		__m256i nst = _mm256_or_si256(_mm256_slli_epi32(cell, 7), _mm256_or_si256(_mm256_slli_epi32(dir, 5), idx));
+		st = _mm256_blendv_epi8(st, nst, act);
+
+		__m256i target = _mm256_and_si256(_mm256_srlv_epi32(_mm256_i32gather_epi32((const int*)Targets, _mm256_srli_epi32(cell, 5), 4), _mm256_and_si256(cell, c31)), one);
+		__m256i hit = _mm256_and_si256(_mm256_cmpeq_epi32(target, one), act);
+		__m256i loop = _mm256_andnot_si256(hit, _mm256_and_si256(_mm256_cmpeq_epi32(st, tor), act));
+		__m256i done = _mm256_or_si256(hit, loop);
+		__m256i res = _mm256_or_si256(_mm256_and_si256(hit, one), _mm256_and_si256(loop, two));
+
+		_mm256_store_si256((__m256i*)State, st);
+		_mm256_store_si256((__m256i*)Tortoise, tor);
+		_mm256_store_si256((__m256i*)Power, pow);
+		_mm256_store_si256((__m256i*)Lam, _mm256_sub_epi32(lam, act));
+		_mm256_store_si256((__m256i*)Steps, _mm256_sub_epi32(_mm256_load_si256((const __m256i*)Steps), act));
+		_mm256_store_si256((__m256i*)Result, _mm256_or_si256(_mm256_load_si256((const __m256i*)Result), res));
+		_mm256_store_si256((__m256i*)Active, _mm256_andnot_si256(done, act));
+		return (unsigned int)_mm256_movemask_ps(_mm256_castsi256_ps(done));
+	}
+	#else
+	//Without vector units there is nothing to gain from interleaving the lanes, each one runs until it finishes
+	unsigned int Step()
+	{
+		unsigned int finished = 0;
+		for (int i = 0; i != LANES; i++)
+		{
+			if (!Active[i]) continue;
+			const int* prog = &Program[i * MAX_COMMANDS];
+			int cell = State[i] >> 7, dir = (State[i] >> 5) & 3, idx = State[i] & 31, st = State[i], tortoise = Tortoise[i], power = Power[i], lam = Lam[i], steps = Steps[i];
+			for (;; lam++)
+			{
+				if (lam == power) { tortoise = st; power *= 2; lam = 0; }
+				int cmd = prog[idx], ncell = cell + (cmd == CMD_FORWARD ? SBoard::Forward(dir) : (cmd == CMD_REVERSE ? -SBoard::Forward(dir) : 0));
+				if (!((Walls[ncell >> 5] >> (ncell & 31)) & 1)) cell = ncell;
+				dir = (dir + (cmd == CMD_TURNLEFT) - (cmd == CMD_TURNRIGHT)) & 3;
+				if (++idx == Count[i]) idx = 0;
+				st = (cell << 7) | (dir << 5) | idx;
+				steps++;
+				if ((Targets[cell >> 5] >> (cell & 31)) & 1) { Result[i] = RESULT_TARGET; break; }
+				if (st == tortoise) { Result[i] = RESULT_LOOP; break; }
+			}
+			State[i] = st; Tortoise[i] = tortoise; Power[i] = power; Lam[i] = lam + 1; Steps[i] = steps;
+			Active[i] = 0;
+			finished |= (1u << i);
+		}
+		return finished;
+	}
+	#endif
+};
+
+//Small splitmix64 generator so every worker can own a seeded stream independent of the global RAND_* state
+struct SRandom
+{
+	unsigned long long State;
+	SRandom(unsigned long long seed, unsigned long long stream) : State(seed ^ (stream * 0xD1342543DE82EF95ull)) { }
+	unsigned int Next()
+	{
+		unsigned long long z = (State += 0x9E3779B97F4A7C15ull);
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+		return (unsigned int)((z ^ (z >> 31)) >> 32);
+	}
+	int Int(int range) { return (int)(((unsigned long long)Next() * (unsigned int)range) >> 32); }
+};
+
+//Thousands of bots with random programs on an SMap for the swarm mode of the game. The state is stored as one array per
+//field so a step is a tight loop over the bots. Pos is where a bot is and NextPos where its current command takes it
+//(both cell<<2|dir like SMap::Move) so the game can animate between them, bots stay on the goal once they reach it.
+struct SBotSwarm
+{
+	int Count, CommandCount, Cleared;
+	std::vector<unsigned int> Pos, NextPos;
+	std::vector<unsigned char> Index;
+	std::vector<SProgram> Programs;
+
+	SBotSwarm() : Count(0), CommandCount(0), Cleared(0) { }
+
+	void Start(const SMap& map, int count, SRandom& rnd)
+	{
+		int start = (map.Start << 2) | map.StartDir;
+		Count = count;
+		CommandCount = map.CommandCount;
+		Cleared = 0;
+		Pos.assign(count, (unsigned int)start);
+		NextPos.resize(count);
+		Index.assign(count, 0);
+		Programs.assign(count, SProgram());
+		for (SProgram& prog : Programs)
+			for (int i = 0; i != CommandCount; i++) prog.Set(i, (ECommand)rnd.Int(CMD_COUNT));
+		for (int i = 0; i != count; i++) NextPos[i] = (unsigned int)map.Move(start, Programs[i][0]);
+	}
+
+	void Step(const SMap& map)
+	{
+		const int goal = map.Goal;
+		for (int i = 0; i != Count; i++)
+		{
+			int pos = NextPos[i], idx = Index[i] + 1;
+			if ((int)Pos[i] == pos && (pos >> 2) == goal) continue; //stays on the goal
+			if (idx == CommandCount) idx = 0;
+			Pos[i] = (unsigned int)pos;
+			Index[i] = (unsigned char)idx;
+			if ((pos >> 2) == goal) { Cleared++; continue; }
+			NextPos[i] = (unsigned int)map.Move(pos, Programs[i][idx]);
+		}
+	}
+};
+
+#if defined(BOT_THREADS)
+typedef std::atomic<int> SSharedInt;
+typedef std::atomic<long long> SSharedCounter;
+static inline void AtomicMin(SSharedInt& v, int x) { for (int cur = v; x < cur && !v.compare_exchange_weak(cur, x);) {} }
+#else
+typedef int SSharedInt;
+typedef long long SSharedCounter;
+static inline void AtomicMin(SSharedInt& v, int x) { if (x < v) v = x; }
+#endif
+
+//Runs fn(0) to fn(count-1) spread over all cores. Work items are picked in order but finish in any order, so callers
+//write results by index and combine them afterwards to get the same outcome for any number of threads.
+template <typename F> static void ParallelFor(int count, const F& fn)
+{
+	#if defined(BOT_THREADS)
+	std::atomic<int> next(0);
+	auto work = [&]() { for (int i; (i = next++) < count;) fn(i); };
+	std::vector<std::thread> workers;
+	for (int i = 1, n = (int)std::thread::hardware_concurrency(); i < n && i < count; i++) workers.emplace_back(work);
+	work();
+	for (std::thread& t : workers) t.join();
+	#else
+	for (int i = 0; i != count; i++) fn(i);
+	#endif
+}
+
+//Outcome of running a program from a start state, RunProgram's result plus the pose where the run ends (the goal or the
+//first state of the cycle)
+struct SOutcome
+{
+	SRunResult Run;
+	int Cell, Dir;
+};
+
+//Bounded LRU cache of program outcomes that can be shared between threads. Keys are a board id (its BoardHash), the
+//packed program with its length and the start state (position and slot). Entries are spread over shards by key hash,
+//each with its own lock, index and list in order of use, so threads rarely wait on each other. Every shard drops its
+//least recently used entry when it is full.
+struct SOutcomeCache
+{
+	enum { SHARDS = 16 };
+	struct SKey
+	{
+		unsigned long long Board, Program;
+		unsigned int Start, Count;
+		bool operator==(const SKey& o) const { return Board == o.Board && Program == o.Program && Start == o.Start && Count == o.Count; }
+	};
+	struct SKeyHash
+	{
+		size_t operator()(const SKey& k) const
+		{
+			unsigned long long h = (k.Board ^ (k.Program * 0x9E3779B97F4A7C15ull) ^ ((unsigned long long)k.Start << 32 | k.Count)) * 0xBF58476D1CE4E5B9ull;
+			return (size_t)(h ^ (h >> 31));
+		}
+	};
+	typedef std::list<std::pair<SKey, SOutcome> > SItems;
+	struct SShard
+	{
+		SItems Items; //most recently used first
+		std::unordered_map<SKey, SItems::iterator, SKeyHash> Index;
+		#if defined(BOT_THREADS)
+		std::mutex Lock;
+		#endif
+	};
+	struct SShardLock
+	{
+		#if defined(BOT_THREADS)
+		std::lock_guard<std::mutex> Guard;
+		SShardLock(SShard& shard) : Guard(shard.Lock) { }
+		#else
+		SShardLock(SShard&) { }
+		#endif
+	};
+
+	SShard Shards[SHARDS];
+	size_t ShardCapacity;
+	SSharedCounter Hits, Misses;
+
+	explicit SOutcomeCache(size_t capacity) : ShardCapacity(capacity > SHARDS ? capacity / SHARDS : 1), Hits(0), Misses(0) { }
+
+	static SKey Key(unsigned long long boardId, const SProgram& prog, int count, const SBotState& start)
+	{
+		SKey key = { boardId, prog.Bits, (unsigned int)((((start.Cell << 2) | start.Dir) << 5) | start.Index), (unsigned int)count };
+		return key;
+	}
+
+	SShard& Shard(const SKey& key) { return Shards[(SKeyHash()(key) >> 8) % SHARDS]; }
+
+	bool Find(const SKey& key, SOutcome& out)
+	{
+		SShard& shard = Shard(key);
+		SShardLock lock(shard);
+		std::unordered_map<SKey, SItems::iterator, SKeyHash>::iterator it = shard.Index.find(key);
+		if (it == shard.Index.end()) { Misses++; return false; }
+		shard.Items.splice(shard.Items.begin(), shard.Items, it->second);
+		out = it->second->second;
+		Hits++;
+		return true;
+	}
+
+	void Insert(const SKey& key, const SOutcome& outcome)
+	{
+		SShard& shard = Shard(key);
+		SShardLock lock(shard);
+		std::unordered_map<SKey, SItems::iterator, SKeyHash>::iterator it = shard.Index.find(key);
+		if (it != shard.Index.end())
+		{
+			it->second->second = outcome;
+			shard.Items.splice(shard.Items.begin(), shard.Items, it->second);
+			return;
+		}
+		if (shard.Items.size() >= ShardCapacity)
+		{
+			shard.Index.erase(shard.Items.back().first);
+			shard.Items.pop_back();
+		}
+		shard.Items.push_front(std::make_pair(key, outcome));
+		shard.Index[key] = shard.Items.begin();
+	}
+
+	void Clear()
+	{
+		for (SShard& shard : Shards)
+		{
+			SShardLock lock(shard);
+			shard.Items.clear();
+			shard.Index.clear();
+		}
+	}
+
+	//RunProgram that looks in the cache first
+	template <typename TBoard> SOutcome Run(unsigned long long boardId, const TBoard& board, const SProgram& prog, int count, const SBotState& start)
+	{
+		SKey key = Key(boardId, prog, count, start);
+		SOutcome res;
+		if (Find(key, res)) return res;
+		res.Run = RunProgram(board, prog, count, start);
+		SBotState bot = start;
+		for (int i = 0; i != res.Run.Steps; i++) bot.Step(board, prog, count);
+		res.Cell = bot.Cell;
+		res.Dir = bot.Dir;
+		Insert(key, res);
+		return res;
+	}
+
+private:
+	SOutcomeCache(const SOutcomeCache&);
+	SOutcomeCache& operator=(const SOutcomeCache&);
+};
+
+enum { BRUTE_MAX_RETRIES = 100000, BRUTE_CHUNK = 1024, BRUTE_SAMPLES = 100, BRUTE_STATS_SEED = 47 };
+
+struct SBruteResult { int Retries, Steps, Commands; };
+
+//Every retry draws its program from its own stream so the outcome only depends on the seed, not on the thread count
+static inline void BruteforceProgram(const SBoard& board, unsigned long long seed, int retry, SProgram& prog)
+{
+	SRandom rnd(seed, (unsigned long long)retry);
+	prog.Bits = 0;
+	for (int i = 0; i != board.CommandCount; i++) prog.Set(i, (ECommand)rnd.Int(CMD_COUNT));
+}
+
+static inline bool BruteforceRetry(const SBoard& board, unsigned long long seed, int retry, SProgram& prog, SRunResult& run)
+{
+	BruteforceProgram(board, seed, retry, prog);
+	SBotState start = { board.Start, board.StartDir, 0 };
+	run = RunProgram(board, prog, board.CommandCount, start);
+	return run.Solved;
+}
+
+//Runs the retries from first to end in batches and lowers best to the lowest retry that solves the board
+static inline void BruteforceRange(const SBoard& board, unsigned long long seed, int first, int end, SSharedInt& best)
+{
+	unsigned int targets[SBoard::PITCH] = { 0 };
+	targets[board.Goal / SBoard::PITCH] = (1u << (board.Goal % SBoard::PITCH));
+	SBotBatch batch(board.Walls, targets);
+	SBotState start = { board.Start, board.StartDir, 0 };
+	SProgram prog;
+	for (int retry = first;;)
+	{
+		for (int lane; retry < end && retry < best && (lane = batch.FreeLane()) >= 0; retry++)
+		{
+			BruteforceProgram(board, seed, retry, prog);
+			batch.Add(lane, prog, board.CommandCount, start, 0, retry);
+		}
+		unsigned int finished = batch.Run();
+		if (!finished) return;
+		for (int lane = 0; lane != SBotBatch::LANES; lane++)
+			if ((finished & (1u << lane)) && batch.Result[lane] == SBotBatch::RESULT_TARGET)
+				AtomicMin(best, (int)batch.Tag[lane]);
+	}
+}
+
+static inline bool BruteforceSample(const SBoard& board, unsigned long long seed, SBruteResult& out)
+{
+	SProgram prog;
+	SRunResult run;
+	SSharedInt best(BRUTE_MAX_RETRIES);
+	BruteforceRange(board, seed, 1, BRUTE_MAX_RETRIES, best);
+	if (best == BRUTE_MAX_RETRIES || !BruteforceRetry(board, seed, best, prog, run)) return false;
+	out.Retries = best;
+	out.Steps = run.Steps;
+	out.Commands = prog.Commands(board.CommandCount);
+	return true;
+}
+
+struct SSolveResult
+{
+	long long Programs, Solutions;
+	int MinSteps, MinCommands;
+	SProgram MinStepsProgram, MinCommandsProgram;
+};
+
+static inline const char* ProgramString(const SProgram& prog, int count)
+{
+	static char buf[SProgram::MAX_COMMANDS + 1];
+	for (int i = 0; i != count; i++) buf[i] = "_FBLR"[prog[i]];
+	buf[count] = '\0';
+	return buf;
+}
+
+static inline void ResetSolveResult(SSolveResult& res)
+{
+	memset(&res, 0, sizeof(res));
+	res.MinSteps = res.MinCommands = 10000000;
+}
+
+//Ties are broken by the program order of the serial walk (which SProgram compares in) so the result does not depend on
+//the order solutions arrive in
+static inline void AddSolution(SSolveResult& res, const SProgram& prog, int count, int steps, long long variants)
+{
+	int commands = prog.Commands(count);
+	res.Programs += variants;
+	res.Solutions += variants;
+	if (steps < res.MinSteps || (steps == res.MinSteps && prog < res.MinStepsProgram))
+	{
+		res.MinSteps = steps;
+		res.MinStepsProgram = prog;
+	}
+	if (commands < res.MinCommands || (commands == res.MinCommands && prog < res.MinCommandsProgram))
+	{
+		res.MinCommands = commands;
+		res.MinCommandsProgram = prog;
+	}
+}
+
+//Walks all programs depth first, slot by slot. As the first pass over the loop runs the commands in order, the bot state
+//after assigning slot N only depends on slots 0 to N and is shared by all programs with that prefix. Fully assigned
+//programs are queued into a lockstep batch which runs them to the goal or into their loop.
+//A run of commands that don't move the bot (NONE and turns) only matters through its length and its net turn because
+//the bot stays on its cell during it, so LR is the same as __ and LLL the same as __R. Only the canonical run (NONE
+//padding followed by the fewest turns, which is also the smallest member in program order) is visited and its result
+//counts for all runs it stands for. Programs without any F or B never leave the start and are not simulated.
+struct SEnumerator
+{
+	const SBoard& Board;
+	SSolveResult& Res;
+	SProgram Cmds;
+	int Split, Task[SProgram::MAX_COMMANDS];
+	long long RunVariants[SProgram::MAX_COMMANDS + 1][4]; //number of runs of length N with net turn T
+	unsigned int Targets[SBoard::PITCH];
+	SBotBatch Batch;
+	const SSharedInt* Stop; //set to give up early, the result is incomplete then
+
+	SEnumerator(const SBoard& board, SSolveResult& res) : Board(board), Res(res), Split(0), Targets(), Batch(board.Walls, Targets), Stop(NULL)
+	{
+		Cmds.Bits = 0;
+		memset(RunVariants, 0, sizeof(RunVariants));
+		RunVariants[0][0] = 1;
+		for (int n = 1; n <= SProgram::MAX_COMMANDS; n++)
+			for (int t = 0; t != 4; t++)
+				RunVariants[n][t] = RunVariants[n - 1][t] + RunVariants[n - 1][(t + 3) & 3] + RunVariants[n - 1][(t + 1) & 3];
+		Targets[board.Goal / SBoard::PITCH] = (1u << (board.Goal % SBoard::PITCH));
+	}
+
+	//Only visit programs that start with the commands fixed by the task
+	bool Allowed(int depth, int cmd) const { return depth >= Split || Task[depth] == cmd; }
+
+	//Goal reached during the first pass at slot depth, all remaining slots are irrelevant
+	void CountSolvedPrefix(int depth, long long variants)
+	{
+		//slots inside the task split beyond the goal are free, only the task with no commands there counts it
+		for (int i = depth + 1; i < Split; i++) if (Task[i] != CMD_NONE) return;
+		SProgram prog = Cmds;
+		for (int i = depth + 1; i != Board.CommandCount; i++) variants *= CMD_COUNT;
+		prog.ClearFrom(depth + 1);
+		AddSolution(Res, prog, Board.CommandCount, depth + 1, variants);
+	}
+
+	void Enumerate(int depth, const SBotState& bot, long long variants, bool moved)
+	{
+		if (Stop && *Stop) return;
+		int count = Board.CommandCount;
+		if (depth == count)
+		{
+			if (!moved) { Res.Programs += variants; return; }
+			int lane = Batch.FreeLane();
+			if (lane < 0) { RunBatch(); lane = Batch.FreeLane(); }
+			Batch.Add(lane, Cmds, count, bot, count, variants);
+			return;
+		}
+		for (int c = CMD_FORWARD; c <= CMD_REVERSE; c++)
+		{
+			if (!Allowed(depth, c)) continue;
+			SBotState next = bot;
+			Cmds.Set(depth, (ECommand)c);
+			next.Move(Board, (ECommand)c);
+			if (next.Cell == Board.Goal) CountSolvedPrefix(depth, variants);
+			else Enumerate(depth + 1, next, variants, true);
+		}
+
+		//a run of non moving commands always extends up to the next move command or the end of the program
+		if (depth && Cmds[depth - 1] != CMD_FORWARD && Cmds[depth - 1] != CMD_REVERSE) return;
+		static const ECommand turns[4][2] = { { CMD_NONE, CMD_NONE }, { CMD_NONE, CMD_TURNLEFT }, { CMD_TURNLEFT, CMD_TURNLEFT }, { CMD_NONE, CMD_TURNRIGHT } };
+		for (int len = 1; depth + len <= count; len++)
+		{
+			for (int t = 0; t != 4; t++)
+			{
+				if (t == 2 && len < 2) continue;
+				bool allowed = true;
+				for (int i = 0; i != len; i++)
+				{
+					Cmds.Set(depth + i, (i < len - 2 ? CMD_NONE : turns[t][i - len + 2]));
+					allowed &= Allowed(depth + i, Cmds[depth + i]);
+				}
+				if (!allowed) continue;
+				SBotState next = bot;
+				next.Dir = (next.Dir + t) & 3;
+				Enumerate(depth + len, next, variants * RunVariants[len][t], moved);
+			}
+		}
+	}
+
+	void RunBatch()
+	{
+		unsigned int finished = Batch.Run();
+		for (int lane = 0; lane != SBotBatch::LANES; lane++)
+		{
+			if (!(finished & (1u << lane))) continue;
+			if (Batch.Result[lane] != SBotBatch::RESULT_TARGET) { Res.Programs += Batch.Tag[lane]; continue; }
+			AddSolution(Res, Batch.Commands(lane), Board.CommandCount, Batch.Steps[lane], Batch.Tag[lane]);
+		}
+	}
+
+	void Flush() { while (Batch.Busy()) RunBatch(); }
+};
+
+//States (cell and direction) that the programs with the command count of a board pass through, the union of their
+//paths up to the goal or their loop. Walks the programs depth first like SEnumerator: the first pass is shared by all
+//programs with the same prefix and only canonical runs of non-moving commands are visited, then every program runs on
+//from the end of its first pass until it enters the goal or Brent's cycle detection finds a repeated state, which
+//happens after the hare passed the whole path. The other runs of the same length and net turn take the same path and
+//only face other directions while turning, those directions are added for every run the canonical one makes.
+//Every cell also gets the first program found entering it, a witness that reaching it is possible.
+//The walk gives up after maxPrograms programs, the set is exact only if it got through all of them (up to
+//REACH_EXACT_COMMANDS with the default), otherwise it holds what the programs walked so far reach. An exact set without
+//the goal proves that no program solves the board, open cells outside of it are dead, no program ever visits them.
+enum { REACH_MAX_PROGRAMS = 1 << 17, REACH_EXACT_COMMANDS = 8 }; //94548 canonical programs of 8 commands
+struct SReachability
+{
+	std::vector<unsigned char> Dirs; //one bit per direction for every cell
+	std::vector<SProgram> Witness;
+	long long Programs;
+	int Reachable, Dead;
+	bool Exact, GoalReachable;
+
+	//stopAtGoal ends the walk once a program is found that reaches the goal, a non-zero stop cancels it (not exact then)
+	template <typename TBoard> explicit SReachability(const TBoard& board, bool stopAtGoal = false, long long maxPrograms = REACH_MAX_PROGRAMS, const SSharedInt* stop = NULL)
+		: Dirs(board.Cells()), Witness(board.Cells()), Programs(0), Reachable(0), Dead(0), Exact(false), GoalReachable(false), MaxPrograms(maxPrograms), Stop(stop), StopAtGoal(stopAtGoal), Done(false)
+	{
+		SProgram prog;
+		prog.Bits = 0;
+		SBotState start = { board.Start, board.StartDir, 0 };
+		Mark(start, prog);
+		if (board.CommandCount >= 1) Walk(board, 0, start, prog);
+		Exact = !Done;
+
+		for (int y = 0; y != board.Height; y++)
+		{
+			for (int x = 0; x != board.Width; x++)
+			{
+				int cell = board.Cell(x, y);
+				if (board.IsWall(cell)) continue;
+				if (Dirs[cell]) Reachable++;
+				else Dead++;
+			}
+		}
+	}
+
+	bool Visited(int cell) const { return Dirs[cell] != 0; }
+	bool Unsolvable() const { return Exact && !GoalReachable; }
+
+private:
+	long long MaxPrograms;
+	const SSharedInt* Stop;
+	bool StopAtGoal, Done;
+
+	void Mark(const SBotState& bot, const SProgram& prog)
+	{
+		if (!Dirs[bot.Cell]) Witness[bot.Cell] = prog;
+		Dirs[bot.Cell] |= (unsigned char)(1 << bot.Dir);
+	}
+
+	//Marks a state of the first pass, the later slots don't matter for getting there and are left empty in the witness
+	void MarkPrefix(const SBotState& bot, const SProgram& prog, int depth)
+	{
+		if (Dirs[bot.Cell]) { Dirs[bot.Cell] |= (unsigned char)(1 << bot.Dir); return; }
+		SProgram prefix = prog;
+		prefix.ClearFrom(depth);
+		Mark(bot, prefix);
+	}
+
+	template <typename TBoard> bool EnteredGoal(const TBoard& board, const SBotState& bot)
+	{
+		if (bot.Cell != board.Goal) return false;
+		GoalReachable = true;
+		if (StopAtGoal) Done = true;
+		return true;
+	}
+
+	//Directions (relative to the one at the start) faced by any run of len non-moving commands with the net turn rot
+	static int TurnMask(int len, int rot)
+	{
+		int mask = 0;
+		for (int k = 0; k <= len; k++)
+			for (int h = 0; h != 4; h++)
+				if ((h == 0 || k >= 2 || (k == 1 && h != 2)) && (((rot - h) & 3) == 0 || len - k >= 2 || (len - k == 1 && ((rot - h) & 3) != 2)))
+					mask |= 1 << h;
+		return mask;
+	}
+
+	void MarkTurns(const SBotState& bot, int mask)
+	{
+		Dirs[bot.Cell] |= (unsigned char)(((mask << bot.Dir) | (mask >> (4 - bot.Dir))) & 15);
+	}
+
+	template <typename TBoard> void Walk(const TBoard& board, int depth, const SBotState& bot, SProgram& prog)
+	{
+		if (Done) return;
+		int count = board.CommandCount;
+		if (depth == count) { Run(board, bot, prog); return; }
+		for (int c = CMD_FORWARD; c <= CMD_REVERSE; c++)
+		{
+			SBotState next = bot;
+			prog.Set(depth, (ECommand)c);
+			next.Move(board, (ECommand)c);
+			MarkPrefix(next, prog, depth + 1);
+			if (!EnteredGoal(board, next)) Walk(board, depth + 1, next, prog);
+		}
+
+		//a run of non moving commands always extends up to the next move command or the end of the program
+		if (depth && prog[depth - 1] != CMD_FORWARD && prog[depth - 1] != CMD_REVERSE) return;
+		static const ECommand turns[4][2] = { { CMD_NONE, CMD_NONE }, { CMD_NONE, CMD_TURNLEFT }, { CMD_TURNLEFT, CMD_TURNLEFT }, { CMD_NONE, CMD_TURNRIGHT } };
+		for (int len = 1; depth + len <= count; len++)
+		{
+			for (int t = 0; t != 4; t++)
+			{
+				if (t == 2 && len < 2) continue;
+				SBotState next = bot;
+				MarkTurns(bot, TurnMask(len, t)); //t is also the net turn of the run
+				for (int i = 0; i != len; i++)
+				{
+					prog.Set(depth + i, (i < len - 2 ? CMD_NONE : turns[t][i - len + 2]));
+					next.Move(board, prog[depth + i]);
+					MarkPrefix(next, prog, depth + i + 1);
+				}
+				Walk(board, depth + len, next, prog);
+			}
+		}
+	}
+
+	//Runs a program on from the end of its first pass
+	template <typename TBoard> void Run(const TBoard& board, SBotState bot, const SProgram& prog)
+	{
+		if (Programs == MaxPrograms || (Stop && *Stop)) { Done = true; return; }
+		int count = board.CommandCount, runMask[SProgram::MAX_COMMANDS] = { 0 };
+		for (int i = 0, len; i < count; i += (len ? len : 1))
+		{
+			int rot = 0;
+			for (len = 0; i + len != count && prog[i + len] != CMD_FORWARD && prog[i + len] != CMD_REVERSE; len++)
+				rot += (prog[i + len] == CMD_TURNLEFT ? 1 : (prog[i + len] == CMD_TURNRIGHT ? 3 : 0));
+			if (len) runMask[i] = TurnMask(len, rot & 3);
+		}
+
+		bot.Index = 0;
+		SBotState tortoise = bot, hare = bot;
+		for (int power = 1, lam = 0; ; lam++)
+		{
+			if (lam == power) { tortoise = hare; power *= 2; lam = 0; }
+			if (runMask[hare.Index]) MarkTurns(hare, runMask[hare.Index]);
+			hare.Step(board, prog, count);
+			Mark(hare, prog);
+			if (EnteredGoal(board, hare) || hare == tortoise) break;
+		}
+		Programs++;
+	}
+};
+
+enum { SOLVE_SPLIT_DEPTH = 2, SOLVE_TASKS = CMD_COUNT * CMD_COUNT };
+
+//Solves all programs starting with the commands encoded in task (one base 5 digit per slot)
+static inline void SolveTask(const SBoard& board, int task, SSolveResult& res, const SSharedInt* stop = NULL)
+{
+	SEnumerator e(board, res);
+	e.Stop = stop;
+	SBotState bot = { board.Start, board.StartDir, 0 };
+	int tasks = 1;
+	e.Split = (board.CommandCount < SOLVE_SPLIT_DEPTH ? board.CommandCount : (int)SOLVE_SPLIT_DEPTH);
+	for (int i = 0; i != e.Split; i++) tasks *= CMD_COUNT;
+	ResetSolveResult(res);
+	if (task >= tasks) return;
+	for (int i = e.Split - 1; i >= 0; i--, task /= CMD_COUNT) e.Task[i] = task % CMD_COUNT;
+	e.Enumerate(0, bot, 1, false);
+	e.Flush();
+}
+
+static inline void MergeSolveResult(SSolveResult& res, const SSolveResult& task)
+{
+	res.Programs += task.Programs;
+	res.Solutions += task.Solutions;
+	if (task.MinSteps < res.MinSteps || (task.MinSteps == res.MinSteps && task.MinStepsProgram < res.MinStepsProgram)) { res.MinSteps = task.MinSteps; res.MinStepsProgram = task.MinStepsProgram; }
+	if (task.MinCommands < res.MinCommands || (task.MinCommands == res.MinCommands && task.MinCommandsProgram < res.MinCommandsProgram)) { res.MinCommands = task.MinCommands; res.MinCommandsProgram = task.MinCommandsProgram; }
+}
+
+//Boards the reachability analysis proves unsolvable are not enumerated, all their programs fail. It only runs where it
+//can be exact (up to REACH_EXACT_COMMANDS). With deadCells it walks all programs instead of stopping at the goal and
+//also gives the number of open cells no program visits, -1 for boards with more commands.
+static inline void Solve(const SBoard* boards, int boardCount, SSolveResult* res, int* deadCells = NULL)
+{
+	std::vector<char> unsolvable(boardCount);
+	ParallelFor(boardCount, [&](int i)
+	{
+		if (deadCells) deadCells[i] = -1;
+		if (boards[i].CommandCount > REACH_EXACT_COMMANDS) return;
+		SReachability reach(boards[i], !deadCells);
+		unsolvable[i] = reach.Unsolvable();
+		if (deadCells && reach.Exact) deadCells[i] = reach.Dead;
+	});
+	std::vector<SSolveResult> tasks(boardCount * SOLVE_TASKS);
+	ParallelFor((int)tasks.size(), [&](int i)
+	{
+		if (unsolvable[i / SOLVE_TASKS]) ResetSolveResult(tasks[i]);
+		else SolveTask(boards[i / SOLVE_TASKS], i % SOLVE_TASKS, tasks[i]);
+	});
+	for (int i = 0; i != boardCount; i++)
+	{
+		ResetSolveResult(res[i]);
+		if (unsolvable[i]) { res[i].Programs = 1; for (int j = 0; j != boards[i].CommandCount; j++) res[i].Programs *= CMD_COUNT; }
+	}
+	for (int i = 0; i != (int)tasks.size(); i++) MergeSolveResult(res[i / SOLVE_TASKS], tasks[i]);
+}
+
+static inline void Solve(const SBoard& board, SSolveResult& res, int* deadCells = NULL)
+{
+	Solve(&board, 1, &res, deadCells);
+}
+
+//Lock-free job queue for work in the background. Jobs are numbered from 0 to count-1, worker threads claim them from an
+//atomic counter and count them as done when they return, so the owner can poll for completion and progress each frame
+//without ever waiting. Cancel stops handing out jobs and sets Stop for running jobs to check. Without threads nothing
+//runs in the background and the owner calls RunSerial once per frame to do the next job itself.
+struct SJobQueue
+{
+	std::function<void(int)> Job;
+	int Count;
+	SSharedInt Next, Done, Stop;
+	#if defined(BOT_THREADS)
+	std::vector<std::thread> Workers;
+	#endif
+
+	SJobQueue() : Count(0), Next(0), Done(0), Stop(0) { }
+	~SJobQueue() { Cancel(); }
+
+	void Start(int count, const std::function<void(int)>& job)
+	{
+		Cancel();
+		Job = job;
+		Count = count;
+		Next = Done = Stop = 0;
+		#if defined(BOT_THREADS)
+		int n = (int)std::thread::hardware_concurrency() - 1; //leave a core to the main thread
+		if (n > count) n = count;
+		if (n < 1) n = 1;
+		for (int w = 0; w != n; w++)
+			Workers.emplace_back([this]() { for (int i; !Stop && (i = Next++) < Count;) { Job(i); Done++; } });
+		#endif
+	}
+
+	void RunSerial()
+	{
+		#if !defined(BOT_THREADS)
+		if (!Stop && Next < Count) { Job(Next++); Done++; }
+		#endif
+	}
+
+	bool Finished() const { return Count && Done == Count; } //all results written by the jobs are visible then
+	float Progress() const { return (Count ? (float)Done / Count : 0.f); }
+
+	//Waits only for the jobs currently running which return early when they check Stop
+	void Cancel()
+	{
+		Stop = 1;
+		#if defined(BOT_THREADS)
+		for (std::thread& t : Workers) t.join();
+		Workers.clear();
+		#endif
+		Count = 0;
+	}
+
+private:
+	SJobQueue(const SJobQueue&);
+	SJobQueue& operator=(const SJobQueue&);
+};
+
+static inline void PrintSolveResult(const char* name, int commandCount, const SSolveResult& res)
+{
+	printf("%s: %lld of %lld programs solve", name, res.Solutions, res.Programs);
+	if (res.Solutions)
+	{
+		printf(" - Shortest: %d steps [%s]", res.MinSteps, ProgramString(res.MinStepsProgram, commandCount));
+		printf(" - Fewest: %d commands [%s]", res.MinCommands, ProgramString(res.MinCommandsProgram, commandCount));
+	}
+	printf("\n");
+}
+
+//Number of moves from every cell to the goal ignoring the direction the bot faces, a lower bound for the steps left
+struct SGoalDistance
+{
+	enum { UNREACHABLE = 0xFFFF };
+	unsigned short Dist[SBoard::PITCH * SBoard::PITCH];
+
+	SGoalDistance(const SBoard& board)
+	{
+		unsigned short queue[SBoard::PITCH * SBoard::PITCH];
+		int head = 0, tail = 0;
+		memset(Dist, 0xFF, sizeof(Dist));
+		Dist[board.Goal] = 0;
+		queue[tail++] = board.Goal;
+		while (head != tail)
+		{
+			int cell = queue[head++];
+			for (int dir = 0; dir != 4; dir++)
+			{
+				int next = cell + SBoard::Forward(dir);
+				if (board.IsWall(next) || Dist[next] != UNREACHABLE) continue;
+				Dist[next] = (unsigned short)(Dist[cell] + 1);
+				queue[tail++] = (unsigned short)next;
+			}
+		}
+	}
+};
+
+//The fewest steps search answers within milliseconds up to SEARCH_MIN_STEPS_COMMANDS, with more commands it can take
+//seconds while the first solution is still found quickly, so the game's hint only looks for that there
+enum ESearchMode { SEARCH_FIRST, SEARCH_MIN_STEPS };
+enum { SEARCH_MIN_STEPS_COMMANDS = 8 };
+
+struct SSearchResult
+{
+	bool Solved;
+	int Steps;
+	long long Nodes;
+	SProgram Program;
+};
+
+//Finds a single solution without counting all programs. A slot gets its command when execution reaches it for the first
+//time, so the search backtracks as soon as the bot enters the goal, leaving the later slots unassigned. Only canonical
+//runs of non-moving commands are visited (see SEnumerator). When looking for the fewest steps, branches that can't beat
+//the best solution so far are cut using the distance to the goal, and loops are abandoned at the same bound.
+struct SSearcher
+{
+	const SBoard& Board;
+	ESearchMode Mode;
+	SSearchResult& Res;
+	SProgram Cmds;
+	int Split, Task[SOLVE_SPLIT_DEPTH];
+	SSharedInt* Shared; //fewest steps found by all tasks searching in parallel
+	const SSharedInt* Stop;
+	SGoalDistance Goal;
+
+	//Allowed commands after the current run of non-moving commands: NONE padding, then L, LL or R
+	enum { RUN_NONE, RUN_L, RUN_LL, RUN_R, RUN_COUNT };
+
+	SSearcher(const SBoard& board, ESearchMode mode, SSearchResult& res) : Board(board), Mode(mode), Res(res), Split(0), Shared(NULL), Stop(NULL), Goal(board)
+	{
+		Cmds.Bits = 0;
+		memset(&Res, 0, sizeof(Res));
+		Res.Steps = 0x7FFFFFFF;
+	}
+
+	void Found(int steps)
+	{
+		Res.Solved = true;
+		Res.Steps = steps;
+		Res.Program = Cmds;
+		if (Shared) AtomicMin(*Shared, steps);
+	}
+
+	//Solutions need fewer steps than this, other tasks only cut ties as the earlier task in program order wins those
+	int Limit() const { return (Shared && *Shared < Res.Steps ? *Shared + 1 : Res.Steps); }
+
+	//Steps until the goal or -1 if the program loops or can't get there in fewer steps than the best solution
+	int Run(const SBotState& start, int startStep) const
+	{
+		SBotState tortoise = start, hare = start;
+		int steps = startStep, count = Board.CommandCount, limit = Limit();
+		for (int power = 1, lam = 0; ; lam++)
+		{
+			if (lam == power) { tortoise = hare; power *= 2; lam = 0; }
+			hare.Step(Board, Cmds, count);
+			if (++steps + Goal.Dist[hare.Cell] >= limit) return -1;
+			if (hare.Cell == Board.Goal) return steps;
+			if (hare == tortoise) return -1;
+		}
+	}
+
+	void Search(int depth, const SBotState& bot, int run, bool moved)
+	{
+		if ((Mode == SEARCH_FIRST && Res.Solved) || (Stop && *Stop)) return;
+		if (depth + Goal.Dist[bot.Cell] >= Limit()) return;
+		Res.Nodes++;
+		int count = Board.CommandCount;
+		if (depth == count)
+		{
+			int steps = (moved ? Run(bot, count) : -1);
+			if (steps >= 0) Found(steps);
+			return;
+		}
+		for (int c = CMD_NONE; c != CMD_COUNT; c++)
+		{
+			if (Mode == SEARCH_FIRST && Res.Solved) return; //later programs in the loop can be shorter but come after it
+			int nextRun = RUN_NONE;
+			if (depth < Split && c != Task[depth]) continue;
+			switch (c)
+			{
+				case CMD_NONE:      if (run != RUN_NONE) continue; break;
+				case CMD_TURNLEFT:  if (run != RUN_NONE && run != RUN_L) continue; nextRun = (run == RUN_NONE ? RUN_L : RUN_LL); break;
+				case CMD_TURNRIGHT: if (run != RUN_NONE) continue; nextRun = RUN_R; break;
+			}
+			SBotState next = bot;
+			Cmds.Set(depth, (ECommand)c);
+			next.Move(Board, (ECommand)c);
+			if (next.Cell != Board.Goal) { Search(depth + 1, next, nextRun, moved || c == CMD_FORWARD || c == CMD_REVERSE); continue; }
+			if (depth + 1 >= Limit()) continue;
+			bool otherTask = false;
+			for (int i = depth + 1; i < Split; i++) otherTask |= (Task[i] != CMD_NONE);
+			if (otherTask) continue;
+			Cmds.ClearFrom(depth + 1);
+			Found(depth + 1);
+		}
+	}
+};
+
+//Searches for the first solution in program order or the one with the fewest steps (the first of them in program
+//order, which matches SSolveResult::MinStepsProgram), returns false if the board can't be solved or stop was set
+static inline bool Search(const SBoard& board, ESearchMode mode, SSearchResult& res, const SSharedInt* stop = NULL)
+{
+	SBotState start = { board.Start, board.StartDir, 0 };
+	if (mode == SEARCH_FIRST || board.CommandCount < SOLVE_SPLIT_DEPTH)
+	{
+		SSearcher s(board, mode, res);
+		s.Stop = stop;
+		if (s.Goal.Dist[board.Start] != SGoalDistance::UNREACHABLE) s.Search(0, start, SSearcher::RUN_NONE, false);
+		if (!res.Solved) res.Steps = 0;
+		return res.Solved;
+	}
+
+	//split by the first slots like Solve and share the bound, ties go to the earliest task
+	SSearchResult tasks[SOLVE_TASKS];
+	SSharedInt shared(0x7FFFFFFF);
+	ParallelFor(SOLVE_TASKS, [&](int task)
+	{
+		SSearcher s(board, mode, tasks[task]);
+		s.Split = SOLVE_SPLIT_DEPTH;
+		s.Shared = &shared;
+		s.Stop = stop;
+		for (int i = SOLVE_SPLIT_DEPTH - 1, t = task; i >= 0; i--, t /= CMD_COUNT) s.Task[i] = t % CMD_COUNT;
+		if (s.Goal.Dist[board.Start] != SGoalDistance::UNREACHABLE) s.Search(0, start, SSearcher::RUN_NONE, false);
+	});
+	memset(&res, 0, sizeof(res));
+	for (const SSearchResult& t : tasks)
+	{
+		res.Nodes += t.Nodes;
+		if (t.Solved && (!res.Solved || t.Steps < res.Steps)) { long long nodes = res.Nodes; res = t; res.Nodes = nodes; }
+	}
+	return res.Solved;
+}
+
+//Random maze for MakeBoard built with a randomized Kruskal on the odd cells. A union-find joins the cells and counts the
+//joins so carving ends after cells - 1 of them, keeping it linear in the board area. A second pass with a new shuffle
+//opens more walls to add loops, and a room in the middle gives space for turning around.
+struct SMazeSets
+{
+	std::vector<int> Parent;
+
+	void Reset(int count) { Parent.resize(count); for (int i = 0; i != count; i++) Parent[i] = i; }
+	int Find(int i) { while (Parent[i] != i) i = Parent[i] = Parent[Parent[i]]; return i; }
+	bool Join(int a, int b) { a = Find(a); b = Find(b); if (a == b) return false; Parent[a] = b; return true; }
+};
+
+static inline void CarveMaze(SMap& map, int width, int height, SRandom& rnd)
+{
+	map.Reset(width, height);
+	for (int y = 0; y != height; y++)
+		for (int x = 0; x != width; x++)
+			map.SetWall(x, y, true);
+
+	//cells are on odd coordinates, an edge is the wall tile between two neighbor cells
+	int cw = (width - 1) / 2, ch = (height - 1) / 2;
+	std::vector<int> edges;
+	edges.reserve(cw * ch * 2);
+	for (int j = 0; j != ch; j++)
+	{
+		for (int i = 0; i != cw; i++)
+		{
+			map.SetWall(1 + i * 2, 1 + j * 2, false);
+			if (i + 1 != cw) edges.push_back((j * cw + i) * 2 + 0);
+			if (j + 1 != ch) edges.push_back((j * cw + i) * 2 + 1);
+		}
+	}
+
+	SMazeSets sets;
+	for (int pass = 0; pass != 2; pass++)
+	{
+		for (int i = (int)edges.size() - 1; i > 0; i--) { int j = rnd.Int(i + 1); int t = edges[i]; edges[i] = edges[j]; edges[j] = t; }
+		sets.Reset(cw * ch);
+		for (int i = 0, joined = 0; i != (int)edges.size() && joined != cw * ch - 1; i++)
+		{
+			int a = edges[i] >> 1, vertical = edges[i] & 1, b = a + (vertical ? cw : 1);
+			if (!sets.Join(a, b)) continue;
+			joined++;
+			map.SetWall(1 + (a % cw) * 2 + !vertical, 1 + (a / cw) * 2 + vertical, false);
+		}
+	}
+
+	int cx = width / 2 | 1, cy = height / 2 | 1;
+	for (int y = cy - 2; y <= cy + 2; y++)
+		for (int x = cx - 2; x <= cx + 2; x++)
+			if (x >= 1 && y >= 1 && x <= width - 2 && y <= height - 2) map.SetWall(x, y, false);
+}
+
+//Carves a maze, picks a random start and places the goal on a cell that a program is known to reach: the reachability
+//walk (over at most MAZE_PROGRAMS programs, all of them for short programs) gives every cell the programs pass through
+//with a witness program, the goal goes to the one with the largest walking distance from the start. Its witness is
+//written to program and solves the maze, returns false if no program left the start cell.
+enum { MAZE_PROGRAMS = 8192 };
+static inline bool GenerateMaze(SMap& map, int width, int height, int commandCount, unsigned long long seed, SProgram& program)
+{
+	SRandom rnd(seed, 0);
+	CarveMaze(map, width, height, rnd);
+	map.CommandCount = commandCount;
+	map.StartDir = rnd.Int(4);
+	map.Start = map.Cell(1 + rnd.Int((width - 1) / 2) * 2, 1 + rnd.Int((height - 1) / 2) * 2);
+	map.Goal = 0; //no goal while walking the programs
+	SReachability reach(map, false, MAZE_PROGRAMS);
+	if (reach.Reachable < 2) return false;
+
+	std::vector<int> dist(map.Cells(), -1), queue;
+	queue.reserve(width * height);
+	dist[map.Start] = 0;
+	queue.push_back(map.Start);
+	int goal = map.Start;
+	for (size_t head = 0; head != queue.size(); head++)
+	{
+		int cell = queue[head];
+		if (reach.Visited(cell) && dist[cell] > dist[goal]) goal = cell;
+		for (int dir = 0; dir != 4; dir++)
+		{
+			int next = cell + map.Forward(dir);
+			if (map.IsWall(next) || dist[next] >= 0) continue;
+			dist[next] = dist[cell] + 1;
+			queue.push_back(next);
+		}
+	}
+	map.Goal = goal;
+	program = reach.Witness[goal];
+	return true;
+}
+
+//Hash of a board in one of its eight orientations, FNV-1a over the size, command count and the tiles including start
+//direction and goal. Transform bit 0 flips x, bit 1 flips y, bit 2 swaps the axes after flipping, 0 hashes the board
+//as it is which is the key of the solution database.
+template <typename TBoard> static inline unsigned long long BoardHash(const TBoard& board, int transform = 0)
+{
+	static const int dirX[4] = { 1, 0, -1, 0 }, dirY[4] = { 0, 1, 0, -1 };
+	bool flipX = (transform & 1) != 0, flipY = (transform & 2) != 0, swap = (transform & 4) != 0;
+	int w = (swap ? board.Height : board.Width), h = (swap ? board.Width : board.Height);
+	int dx = dirX[board.StartDir] * (flipX ? -1 : 1), dy = dirY[board.StartDir] * (flipY ? -1 : 1);
+	if (swap) { int tmp = dx; dx = dy; dy = tmp; }
+	int startDir = (dx == 1 ? 0 : (dy == 1 ? 1 : (dx == -1 ? 2 : 3)));
+
+	unsigned long long hash = 0xCBF29CE484222325ull;
+	auto add = [&hash](unsigned int v) { hash = (hash ^ v) * 0x100000001B3ull; };
+	add((unsigned int)w);
+	add((unsigned int)h);
+	add((unsigned int)board.CommandCount);
+	for (int v = 0; v != h; v++)
+	{
+		for (int u = 0; u != w; u++)
+		{
+			int a = (swap ? v : u), b = (swap ? u : v);
+			int cell = board.Cell(flipX ? board.Width - 1 - a : a, flipY ? board.Height - 1 - b : b);
+			add(cell == board.Start ? 'R' + startDir : (cell == board.Goal ? 'G' : (board.IsWall(cell) ? '#' : ' ')));
+		}
+	}
+	return hash;
+}
+
+//Hash that is the same for all rotations and reflections of a board (the smallest of the eight), used to find
+//duplicate generated boards
+static inline unsigned long long CanonicalBoardHash(const SMap& map)
+{
+	unsigned long long best = ~0ull;
+	for (int t = 0; t != 8; t++)
+	{
+		unsigned long long hash = BoardHash(map, t);
+		if (hash < best) best = hash;
+	}
+	return best;
+}
+
+#endif //_BOTLOOP_SIM_
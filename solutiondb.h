@@ -0,0 +1,164 @@
+/*
+  BOTLOOP
+  Copyright (C) 2020 Bernhard Schelling
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#ifndef _BOTLOOP_SOLUTIONDB_
+#define _BOTLOOP_SOLUTIONDB_
+
+//Solution database built offline by botcli: a header followed by an open addressing hash table of SlotCount entries
+//(a power of two, at most half full). An entry is found by its key (BoardHash of the board as it is, which includes
+//the command count) at slot key & (SlotCount - 1) or one of the following slots before the first empty one, so a
+//lookup touches a few consecutive entries right in the mapped file. Each entry holds the solve statistics and the
+//packed programs with the fewest steps and the fewest commands. Unsolvable boards have entries too (no solutions).
+//As different boards can share a key, an entry also holds the board size and a second hash walking the tiles in
+//another order, a lookup that finds a key with a different check treats the board as unknown. All values are little
+//endian.
+//
+//  SSolutionDBHeader
+//  SSolutionDBEntry Slots[SlotCount]   (Key 0 marks an empty slot)
+
+#include "levelpack.h"
+
+enum { SOLUTIONDB_VERSION = 2, SOLUTIONDB_MIN_SLOTS = 16 };
+
+struct SSolutionDBHeader
+{
+	char Magic[4]; //BSDB
+	unsigned int Version, SlotCount, EntryCount;
+};
+
+struct SSolutionDBEntry
+{
+	unsigned long long Key;
+	unsigned short Width, Height;
+	unsigned int Check;
+	long long Programs, Solutions;
+	int MinSteps, MinCommands;
+	unsigned long long MinStepsProgram, MinCommandsProgram; //SProgram bits
+};
+
+template <typename TBoard> static inline unsigned long long SolutionKey(const TBoard& board)
+{
+	unsigned long long key = BoardHash(board);
+	return (key ? key : 1);
+}
+
+//BoardHash of the board flipped on both axes and transposed, which hashes the tiles in a different order than the key
+template <typename TBoard> static inline unsigned int SolutionCheck(const TBoard& board)
+{
+	unsigned long long hash = BoardHash(board, 7);
+	return (unsigned int)(hash ^ (hash >> 32));
+}
+
+struct SSolutionDB : SMappedFile
+{
+	//Returns false if the file is missing or not a valid database
+	bool Load(std::vector<unsigned char>& data) { return SMappedFile::Load(data) && Open(); }
+	bool Load(const char* path) { return SMappedFile::Load(path) && Open(); }
+
+	int Count() const { return (Data ? (int)Header().EntryCount : 0); }
+	const SSolutionDBHeader& Header() const { return *(const SSolutionDBHeader*)Data; }
+
+	const SSolutionDBEntry* Find(unsigned long long key) const
+	{
+		if (!Data) return NULL;
+		const SSolutionDBEntry* slots = (const SSolutionDBEntry*)(Data + sizeof(SSolutionDBHeader));
+		unsigned int mask = Header().SlotCount - 1;
+		for (unsigned int i = (unsigned int)key & mask, n = 0; n <= mask; i = (i + 1) & mask, n++)
+		{
+			if (slots[i].Key == key) return &slots[i];
+			if (!slots[i].Key) return NULL;
+		}
+		return NULL;
+	}
+
+	//Fills in the solve result of a board seen when the database was built, returns false for unknown boards
+	template <typename TBoard> bool Lookup(const TBoard& board, SSolveResult& res) const
+	{
+		const SSolutionDBEntry* e = Find(SolutionKey(board));
+		if (!e || e->Width != board.Width || e->Height != board.Height || e->Check != SolutionCheck(board)) return false;
+		res.Programs = e->Programs;
+		res.Solutions = e->Solutions;
+		res.MinSteps = e->MinSteps;
+		res.MinCommands = e->MinCommands;
+		res.MinStepsProgram.Bits = e->MinStepsProgram;
+		res.MinCommandsProgram.Bits = e->MinCommandsProgram;
+		return true;
+	}
+
+private:
+	bool Open()
+	{
+		const SSolutionDBHeader* h = (const SSolutionDBHeader*)Data;
+		if (Size < sizeof(SSolutionDBHeader) || memcmp(h->Magic, "BSDB", 4) || h->Version != SOLUTIONDB_VERSION || !h->SlotCount ||
+			(h->SlotCount & (h->SlotCount - 1)) || h->EntryCount >= h->SlotCount || (Size - sizeof(SSolutionDBHeader)) / sizeof(SSolutionDBEntry) < h->SlotCount) { Close(); return false; }
+		return true;
+	}
+};
+
+//Collects the entries (a board added again replaces its entry, a different board with the same key is left out and
+//solved when looked up) and writes the table in one go
+struct SSolutionDBWriter
+{
+	std::vector<SSolutionDBEntry> Entries;
+
+	template <typename TBoard> void Add(const TBoard& board, const SSolveResult& res)
+	{
+		SSolutionDBEntry e;
+		e.Key = SolutionKey(board);
+		e.Width = (unsigned short)board.Width;
+		e.Height = (unsigned short)board.Height;
+		e.Check = SolutionCheck(board);
+		e.Programs = res.Programs;
+		e.Solutions = res.Solutions;
+		e.MinSteps = (res.Solutions ? res.MinSteps : 0);
+		e.MinCommands = (res.Solutions ? res.MinCommands : 0);
+		e.MinStepsProgram = (res.Solutions ? res.MinStepsProgram.Bits : 0);
+		e.MinCommandsProgram = (res.Solutions ? res.MinCommandsProgram.Bits : 0);
+		Entries.push_back(e);
+	}
+
+	bool Write(FILE* f) const
+	{
+		unsigned int slotCount = SOLUTIONDB_MIN_SLOTS;
+		while (slotCount < Entries.size() * 2) slotCount *= 2;
+		std::vector<SSolutionDBEntry> slots(slotCount);
+		memset(slots.data(), 0, slotCount * sizeof(SSolutionDBEntry));
+		unsigned int count = 0;
+		for (const SSolutionDBEntry& e : Entries)
+		{
+			unsigned int i = (unsigned int)e.Key & (slotCount - 1);
+			while (slots[i].Key && slots[i].Key != e.Key) i = (i + 1) & (slotCount - 1);
+			if (slots[i].Key && (slots[i].Width != e.Width || slots[i].Height != e.Height || slots[i].Check != e.Check)) continue;
+			if (!slots[i].Key) count++;
+			slots[i] = e;
+		}
+
+		SSolutionDBHeader h;
+		memcpy(h.Magic, "BSDB", 4);
+		h.Version = SOLUTIONDB_VERSION;
+		h.SlotCount = slotCount;
+		h.EntryCount = count;
+		return (fwrite(&h, sizeof(h), 1, f) == 1 && fwrite(slots.data(), sizeof(SSolutionDBEntry), slotCount, f) == slotCount);
+	}
+};
+
+#endif //_BOTLOOP_SOLUTIONDB_